@@ -14,19 +14,11 @@ sudo apt install -y \
   pkg-config \
   libglib2.0-dev \
   libnm-dev \
+  systemtap-sdt-dev \
   bluez 
 
-sudo rfkill unblock bluetooth
-echo waiting for bluez ...
-sleep 5
-#Setup Bluetooth
-sudo btmgmt power on
-sudo btmgmt connectable on
-sudo btmgmt discov on
-#sudo rfkill unblock bluetooth
-#sudo bluetoothctl power on
-#sudo bluetoothctl discoverable on
-#sudo bluetoothctl pairable on
+# Bluetooth power-up (rfkill, Powered, discoverable) is handled by the
+# daemon itself at every start, see [adapter] in provision.conf.
 
 # get project
 sudo git clone "$PROJECT_REPO" "$PROJECT_DIR"
@@ -24,13 +24,12 @@
 #include "util/log.hpp"
 
 #include <gio/gio.h>
+#include <memory>
 #include <stdexcept>
 #include <string>
 
 namespace {
 
-constexpr const char* ADV_PATH = "/org/bluez/provision/advertisement0";
-
 // Introspection XML
 const char* XML_ADV = R"XML(
 <node>
@@ -126,19 +125,36 @@ std::runtime_error make_error(const std::string& prefix, GError* err)
     return std::runtime_error(msg);
 }
 
+void on_alias_set(GObject* source, GAsyncResult* res, gpointer user_data)
+{
+    std::unique_ptr<std::string> name(static_cast<std::string*>(user_data));
+
+    GError* err = nullptr;
+    GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), res, &err);
+
+    if (reply) {
+        g_variant_unref(reply);
+        provision::log::info("BLE adapter alias set to '" + *name + "'");
+        return;
+    }
+
+    provision::log::info(std::string("Failed to set BLE alias: ") +
+                         (err && err->message ? err->message : "unknown error"));
+    if (err) g_error_free(err);
+}
+
 } // namespace
 
 namespace provision::adv {
 
 void set_ble_alias(GDBusConnection* bus,
-                          const std::string& name)
+                   const std::string& adapter_path,
+                   const std::string& name)
 {
-    GError* err = nullptr;
-
-    g_dbus_connection_call_sync(
+    g_dbus_connection_call(
         bus,
         "org.bluez",
-        "/org/bluez/hci0",
+        adapter_path.c_str(),
         "org.freedesktop.DBus.Properties",
         "Set",
         g_variant_new(
@@ -151,17 +167,9 @@ void set_ble_alias(GDBusConnection* bus,
         G_DBUS_CALL_FLAGS_NONE,
         -1,
         nullptr,
-        &err
+        on_alias_set,
+        new std::string(name)
     );
-
-    if (err) {
-        provision::log::info(
-            std::string("Failed to set BLE alias: ") + err->message);
-        g_error_free(err);
-    } else {
-        provision::log::info(
-            "BLE adapter alias set to '" + name + "'");
-    }
 }
 
 
@@ -20,12 +20,20 @@
 #include <string>
 namespace provision::adv {
 
+inline constexpr const char* ADV_PATH = "/org/bluez/provision/advertisement0";
+
 /**
  * Export the BLE advertisement object.
  *
  * Throws std::runtime_error on failure.
  */
 void export_advertisement(GDBusConnection* system_bus);
-void set_ble_alias(GDBusConnection* bus, const std::string& name);
+
+/**
+ * Set Adapter1.Alias (the advertised pairing name). Async, result logged.
+ */
+void set_ble_alias(GDBusConnection* bus,
+                   const std::string& adapter_path,
+                   const std::string& name);
 
 } // namespace provision::adv
@@ -0,0 +1,536 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   Implementation of the on-device benchmark.
+ *
+ * Notes:
+ *   - Runs on the main thread; sync calls are the thing being measured
+ *   - Notify: a private characteristic is forced into notifying state.
+ *     Nothing is registered with bluetoothd, so no match rule routes the
+ *     signals to it: what is measured is building the signals and
+ *     flushing them to dbus-daemon (reported as notify_bus_emit)
+ *   - Each burst is one pump tick's worth of fragments sent from idle, so
+ *     notify_characteristic_burst emits and flushes synchronously; the
+ *     pump is allowed to go idle between bursts
+ *   - The timed section is signal build + emit + flush only: the notify
+ *     path writes no log line on success, and log cost is reported on
+ *     its own (log_write_us); the report's "excludes" says so
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+
+#include "bench/hw_bench.hpp"
+#include "dbus/adapter_power.hpp"
+#include "dbus/bluez_client.hpp"
+#include "gatt/characteristic.hpp"
+#include "gatt/command.hpp"
+#include "gatt/device_info.hpp"
+#include "gatt/extension.hpp"
+#include "gatt/object_manager.hpp"
+#include "gatt/service.hpp"
+#include "gatt/state.hpp"
+#include "util/config.hpp"
+#include "util/log.hpp"
+#include "wifi/scan.hpp"
+#include "wifi/sim_backend.hpp"
+
+#include <NetworkManager.h>
+#include <gio/gio.h>
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <vector>
+
+#include <sys/utsname.h>
+
+namespace {
+
+struct Options {
+    int scans{5};
+    int nm_inits{3};
+    int pings{50};
+    int bursts{50};
+    int log_writes{200};
+    std::string out;
+};
+
+constexpr const char* BENCH_CHAR_PATH = "/org/bluez/provision/bench0";
+constexpr const char* BENCH_CHAR_UUID = "9a7d0000-7c2a-4f8e-9b32-9b3e6d4a00ff";
+
+// One pump tick: sent synchronously when the pump is idle.
+constexpr size_t BURST_FRAGMENTS = provision::gatt::NOTIFY_FRAGMENTS_PER_TICK;
+constexpr size_t FRAGMENT_BYTES = 180;
+
+// Longer than two notify pump intervals: the pump has stopped after it.
+constexpr guint PUMP_SETTLE_MS = 25;
+
+static const char* BENCH_FLAGS[] = {
+    "notify",
+    nullptr
+};
+
+void usage()
+{
+    std::fprintf(stderr,
+        "usage: provision-ble --bench [--scans N] [--nm-inits N] [--pings N]\n"
+        "                     [--bursts N] [--log-writes N] [--out file]\n");
+}
+
+bool parse_options(int argc, char** argv, Options& opt)
+{
+    for (int i = 0; i < argc; ++i) {
+        const char* a = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (std::strcmp(a, "--scans") == 0 && has_value)
+            opt.scans = std::atoi(argv[++i]);
+        else if (std::strcmp(a, "--nm-inits") == 0 && has_value)
+            opt.nm_inits = std::atoi(argv[++i]);
+        else if (std::strcmp(a, "--pings") == 0 && has_value)
+            opt.pings = std::atoi(argv[++i]);
+        else if (std::strcmp(a, "--bursts") == 0 && has_value)
+            opt.bursts = std::atoi(argv[++i]);
+        else if (std::strcmp(a, "--log-writes") == 0 && has_value)
+            opt.log_writes = std::atoi(argv[++i]);
+        else if (std::strcmp(a, "--out") == 0 && has_value)
+            opt.out = argv[++i];
+        else
+            return false;
+    }
+    return true;
+}
+
+double ms_since(gint64 start_us)
+{
+    return static_cast<double>(g_get_monotonic_time() - start_us) / 1000.0;
+}
+
+gboolean on_settled(gpointer user_data)
+{
+    g_main_loop_quit(static_cast<GMainLoop*>(user_data));
+    return G_SOURCE_REMOVE;
+}
+
+/**
+ * Run the default main context for ms milliseconds.
+ */
+void run_for(guint ms)
+{
+    GMainLoop* loop = g_main_loop_new(nullptr, FALSE);
+    g_timeout_add(ms, on_settled, loop);
+    g_main_loop_run(loop);
+    g_main_loop_unref(loop);
+}
+
+// -----------------------------------------------------------------------------
+// Report helpers
+// -----------------------------------------------------------------------------
+
+void appendf(std::string& out, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+void appendf(std::string& out, const char* fmt, ...)
+{
+    char buf[512];
+
+    va_list ap;
+    va_start(ap, fmt);
+    int n = std::vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+
+    if (n > 0)
+        out.append(buf, std::min(static_cast<size_t>(n), sizeof(buf) - 1));
+}
+
+double percentile(std::vector<double> v, double p)
+{
+    std::sort(v.begin(), v.end());
+    size_t idx = static_cast<size_t>(p * static_cast<double>(v.size() - 1) + 0.5);
+    return v[std::min(idx, v.size() - 1)];
+}
+
+/**
+ * {"n":..,"min":..,"p50":..,"p90":..,"p99":..,"max":..,"mean":..} or null.
+ */
+std::string dist_json(const std::vector<double>& v)
+{
+    if (v.empty())
+        return "null";
+
+    double sum = 0;
+    for (double x : v)
+        sum += x;
+
+    std::string out;
+    appendf(out,
+            "{\"n\":%zu,\"min\":%.3f,\"p50\":%.3f,\"p90\":%.3f,\"p99\":%.3f,"
+            "\"max\":%.3f,\"mean\":%.3f}",
+            v.size(), percentile(v, 0.0), percentile(v, 0.5), percentile(v, 0.9),
+            percentile(v, 0.99), percentile(v, 1.0), sum / static_cast<double>(v.size()));
+    return out;
+}
+
+std::string number_or_null(double v)
+{
+    if (v < 0)
+        return "null";
+    std::string out;
+    appendf(out, "%.3f", v);
+    return out;
+}
+
+std::string json_string(const std::string& in)
+{
+    std::string out = "\"";
+    for (unsigned char c : in) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += static_cast<char>(c);
+        } else if (c < 0x20) {
+            appendf(out, "\\u%04x", c);
+        } else {
+            out += static_cast<char>(c);
+        }
+    }
+    return out + "\"";
+}
+
+/**
+ * Trimmed file contents (device-tree strings end in NUL), or empty.
+ */
+std::string read_text(const char* path)
+{
+    gchar* data = nullptr;
+    gsize len = 0;
+    if (!g_file_get_contents(path, &data, &len, nullptr))
+        return {};
+
+    std::string s(data, strnlen(data, len));
+    g_free(data);
+    while (!s.empty() && (s.back() == '\n' || s.back() == ' '))
+        s.pop_back();
+    return s;
+}
+
+std::string os_pretty_name()
+{
+    const std::string release = read_text("/etc/os-release");
+    const std::string key = "PRETTY_NAME=";
+
+    size_t p = release.find(key);
+    if (p == std::string::npos)
+        return {};
+    p += key.size();
+
+    size_t end = release.find('\n', p);
+    std::string v = release.substr(p, end == std::string::npos ? std::string::npos : end - p);
+    if (v.size() >= 2 && v.front() == '"' && v.back() == '"')
+        v = v.substr(1, v.size() - 2);
+    return v;
+}
+
+// -----------------------------------------------------------------------------
+// Measurements
+// -----------------------------------------------------------------------------
+
+struct AdapterTiming {
+    double find_ms{-1};
+    double power_ms{-1};
+    std::string path;
+    std::string error;
+};
+
+AdapterTiming time_adapter(GDBusConnection* bus)
+{
+    AdapterTiming t;
+    GMainLoop* loop = g_main_loop_new(nullptr, FALSE);
+    const gint64 start = g_get_monotonic_time();
+
+    provision::bluez::find_adapter_async(
+        bus,
+        [&](bool ok, const provision::bluez::AdapterPaths& paths, const std::string& find_err) {
+            if (!ok) {
+                t.error = find_err;
+                g_main_loop_quit(loop);
+                return;
+            }
+
+            t.find_ms = ms_since(start);
+            t.path = paths.adapter_path;
+
+            const gint64 power_start = g_get_monotonic_time();
+            provision::bluez::ensure_adapter_ready_async(
+                bus, paths.adapter_path,
+                [&, power_start](bool ready, const std::string& power_err) {
+                    if (ready)
+                        t.power_ms = ms_since(power_start);
+                    else
+                        t.error = power_err;
+                    g_main_loop_quit(loop);
+                });
+        });
+
+    g_main_loop_run(loop);
+    g_main_loop_unref(loop);
+    return t;
+}
+
+std::vector<double> time_bluez_pings(GDBusConnection* bus, int count, std::string& error)
+{
+    std::vector<double> ms;
+
+    for (int i = 0; i < count; ++i) {
+        GError* err = nullptr;
+        const gint64 start = g_get_monotonic_time();
+
+        GVariant* reply = g_dbus_connection_call_sync(
+            bus, "org.bluez", "/", "org.freedesktop.DBus.Peer", "Ping",
+            nullptr, nullptr, G_DBUS_CALL_FLAGS_NONE, 2000, nullptr, &err);
+
+        if (!reply) {
+            error = err ? err->message : "unknown error";
+            if (err) g_error_free(err);
+            break;
+        }
+
+        ms.push_back(ms_since(start));
+        g_variant_unref(reply);
+    }
+
+    return ms;
+}
+
+std::vector<double> time_nm_inits(int count, std::string& error)
+{
+    std::vector<double> ms;
+
+    for (int i = 0; i < count; ++i) {
+        GError* err = nullptr;
+        const gint64 start = g_get_monotonic_time();
+
+        NMClient* client = nm_client_new(nullptr, &err);
+        if (!client) {
+            error = err ? err->message : "unknown error";
+            if (err) g_error_free(err);
+            break;
+        }
+
+        ms.push_back(ms_since(start));
+        g_object_unref(client);
+    }
+
+    return ms;
+}
+
+struct NotifyTiming {
+    std::vector<double> burst_us;
+    double msgs_per_s{-1};
+};
+
+NotifyTiming time_notify(bool fast_path, int bursts)
+{
+    NotifyTiming t;
+    provision::gatt::set_notify_fast_path(fast_path);
+
+    std::vector<guint8> payload(FRAGMENT_BYTES);
+    double total_us = 0;
+
+    for (int b = 0; b < bursts; ++b) {
+        // Let the pump go idle so the burst is emitted synchronously.
+        run_for(PUMP_SETTLE_MS);
+
+        std::vector<GVariant*> fragments;
+        for (size_t f = 0; f < BURST_FRAGMENTS; ++f) {
+            payload[0] = static_cast<guint8>(f);
+            fragments.push_back(g_variant_new_fixed_array(
+                G_VARIANT_TYPE_BYTE, payload.data(), payload.size(), 1));
+        }
+
+        const gint64 start = g_get_monotonic_time();
+        provision::gatt::notify_characteristic_burst(BENCH_CHAR_PATH, fragments);
+        const double us = static_cast<double>(g_get_monotonic_time() - start);
+
+        t.burst_us.push_back(us);
+        total_us += us;
+    }
+
+    if (total_us > 0)
+        t.msgs_per_s = static_cast<double>(bursts) * BURST_FRAGMENTS / (total_us / 1e6);
+    return t;
+}
+
+std::vector<double> time_scans(int count, std::vector<double>& ssid_counts)
+{
+    std::vector<double> ms;
+
+    for (int i = 0; i < count; ++i) {
+        const gint64 start = g_get_monotonic_time();
+        const auto ssids = provision::wifi::scan_ssids();
+        ms.push_back(ms_since(start));
+        ssid_counts.push_back(static_cast<double>(ssids.size()));
+    }
+
+    return ms;
+}
+
+std::vector<double> time_log_writes(int count)
+{
+    std::vector<double> us;
+    const std::string line(96, 'x');
+
+    for (int i = 0; i < count; ++i) {
+        const gint64 start = g_get_monotonic_time();
+        provision::log::info("bench: " + line);
+        us.push_back(static_cast<double>(g_get_monotonic_time() - start));
+    }
+
+    return us;
+}
+
+} // namespace
+
+namespace provision::bench {
+
+int run(int argc, char** argv)
+{
+    Options opt;
+    if (!parse_options(argc, argv, opt)) {
+        usage();
+        return 2;
+    }
+
+    // --- Startup phases, in the daemon's order ---
+    gint64 phase = g_get_monotonic_time();
+    provision::log::init(provision::log::DEFAULT_LOG_PATH);
+    provision::config::load();
+    provision::log::init(
+        provision::config::get_string("log", "path", provision::log::DEFAULT_LOG_PATH));
+    const double config_ms = ms_since(phase);
+
+    provision::log::info("bench: starting");
+
+    phase = g_get_monotonic_time();
+    GError* err = nullptr;
+    GDBusConnection* bus = g_bus_get_sync(G_BUS_TYPE_SYSTEM, nullptr, &err);
+    if (!bus) {
+        std::fprintf(stderr, "provision-ble --bench: system bus: %s\n",
+                     err ? err->message : "unknown error");
+        if (err) g_error_free(err);
+        return 1;
+    }
+    const double bus_ms = ms_since(phase);
+
+    phase = g_get_monotonic_time();
+    try {
+        provision::gatt::export_object_manager(bus);
+        provision::gatt::export_service(bus);
+        provision::gatt::export_device_info(bus);
+        provision::gatt::export_state(bus);
+        provision::gatt::export_command(bus);
+        provision::gatt::export_extensions(bus);
+        provision::gatt::export_characteristic(
+            bus, BENCH_CHAR_UUID, BENCH_CHAR_PATH, provision::gatt::SERVICE_PATH,
+            BENCH_FLAGS, nullptr);
+    } catch (const std::exception& ex) {
+        std::fprintf(stderr, "provision-ble --bench: export: %s\n", ex.what());
+        g_object_unref(bus);
+        return 1;
+    }
+    const double export_ms = ms_since(phase);
+
+    const AdapterTiming adapter = time_adapter(bus);
+
+    // --- Subsystems ---
+    const bool sim = provision::wifi::sim_backend_enabled();
+
+    std::string nm_error;
+    const auto nm_ms = sim ? std::vector<double>{} : time_nm_inits(opt.nm_inits, nm_error);
+
+    std::string ping_error;
+    const auto ping_ms = time_bluez_pings(bus, opt.pings, ping_error);
+
+    std::vector<double> ssid_counts;
+    const auto scan_ms = time_scans(opt.scans, ssid_counts);
+
+    provision::gatt::set_characteristic_notifying(BENCH_CHAR_PATH, true);
+    const NotifyTiming fast = time_notify(true, opt.bursts);
+    const NotifyTiming legacy = time_notify(false, opt.bursts);
+    provision::gatt::set_characteristic_notifying(BENCH_CHAR_PATH, false);
+
+    const auto log_us = time_log_writes(opt.log_writes);
+
+    // --- Report ---
+    struct utsname uts{};
+    uname(&uts);
+
+    std::string r;
+    r += "{\n";
+    appendf(r, "  \"model\": %s,\n",
+            json_string(read_text("/proc/device-tree/model")).c_str());
+    appendf(r, "  \"os\": %s,\n", json_string(os_pretty_name()).c_str());
+    appendf(r, "  \"kernel\": %s,\n", json_string(uts.release).c_str());
+    appendf(r, "  \"wifi_backend\": \"%s\",\n", sim ? "sim" : "nm");
+    appendf(r, "  \"startup_ms\": {\"config\": %.3f, \"bus\": %.3f, \"gatt_export\": %.3f, "
+               "\"adapter_find\": %s, \"adapter_power\": %s},\n",
+            config_ms, bus_ms, export_ms,
+            number_or_null(adapter.find_ms).c_str(),
+            number_or_null(adapter.power_ms).c_str());
+    appendf(r, "  \"adapter\": %s,\n", json_string(adapter.path).c_str());
+    appendf(r, "  \"nm_client_init_ms\": %s,\n", dist_json(nm_ms).c_str());
+    appendf(r, "  \"bluez_ping_ms\": %s,\n", dist_json(ping_ms).c_str());
+    appendf(r, "  \"scan_ms\": %s,\n", dist_json(scan_ms).c_str());
+    appendf(r, "  \"scan_ssids\": %s,\n", dist_json(ssid_counts).c_str());
+    appendf(r, "  \"notify_bus_emit\": {\"fragment_bytes\": %zu, \"fragments_per_burst\": %zu,\n",
+            FRAGMENT_BYTES, BURST_FRAGMENTS);
+    appendf(r, "    \"excludes\": [\"log_write\", \"bluetoothd\", \"att_radio\"],\n");
+    appendf(r, "    \"fast\": {\"burst_us\": %s, \"msgs_per_s\": %s},\n",
+            dist_json(fast.burst_us).c_str(), number_or_null(fast.msgs_per_s).c_str());
+    appendf(r, "    \"legacy\": {\"burst_us\": %s, \"msgs_per_s\": %s}},\n",
+            dist_json(legacy.burst_us).c_str(), number_or_null(legacy.msgs_per_s).c_str());
+    appendf(r, "  \"log_write_us\": %s,\n", dist_json(log_us).c_str());
+
+    std::string errors;
+    for (const auto& e : {std::make_pair("adapter", adapter.error),
+                          std::make_pair("nm", nm_error),
+                          std::make_pair("bluez_ping", ping_error)}) {
+        if (e.second.empty())
+            continue;
+        if (!errors.empty())
+            errors += ", ";
+        errors += std::string("\"") + e.first + "\": " + json_string(e.second);
+    }
+    r += "  \"errors\": {" + errors + "}\n";
+    r += "}\n";
+
+    std::fputs(r.c_str(), stdout);
+
+    if (!opt.out.empty()) {
+        GError* write_err = nullptr;
+        if (!g_file_set_contents(opt.out.c_str(), r.c_str(),
+                                 static_cast<gssize>(r.size()), &write_err)) {
+            std::fprintf(stderr, "provision-ble --bench: %s\n",
+                         write_err ? write_err->message : "write failed");
+            if (write_err) g_error_free(write_err);
+        }
+    }
+
+    provision::log::info("bench: done");
+    g_object_unref(bus);
+    return 0;
+}
+
+} // namespace provision::bench
@@ -0,0 +1,40 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   On-device benchmark run mode (provision-ble --bench).
+ *
+ * Notes:
+ *   - Measures on the target: startup phases, NMClient init, D-Bus round
+ *     trips to bluetoothd, Wi-Fi scan latency, notification emission rate
+ *     onto the system bus (fast and legacy path) and log write latency
+ *   - Uses the same config, log file, bus and adapter as the daemon; stop
+ *     provision-ble.service first so scans and the adapter are not shared
+ *   - Never registers with BlueZ or advertises
+ *   - Prints one JSON report on stdout (and to --out if given)
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+#pragma once
+
+namespace provision::bench {
+
+/**
+ * Run the benchmark. argv holds the options after --bench:
+ *   [--scans N] [--nm-inits N] [--pings N] [--bursts N]
+ *   [--log-writes N] [--out file]
+ *
+ * Returns the process exit status (0 ok, 1 setup failure, 2 usage).
+ */
+int run(int argc, char** argv);
+
+} // namespace provision::bench
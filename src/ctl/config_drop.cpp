@@ -0,0 +1,257 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   Implementation of the offline configuration drop.
+ *
+ * Notes:
+ *   - Runs once, on the main thread before the main loop starts
+ *   - The drop is only wiped once CONNECTED proves it worked; until then
+ *     it stays on disk, so a failed connect or a crash loses nothing and
+ *     the next boot tries it again
+ *   - The wipe (overwrite + fsync on the SD card) runs on a short-lived
+ *     thread, off the main loop
+ *   - The boot partition is FAT; overwriting before unlink is best
+ *     effort (no journal, but flash wear levelling may keep old blocks)
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+
+#include "ctl/config_drop.hpp"
+#include "dbus/registration.hpp"
+#include "gatt/command.hpp"
+#include "gatt/state.hpp"
+#include "util/blocking_probe.hpp"
+#include "util/config.hpp"
+#include "util/log.hpp"
+
+#include <glib.h>
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+static bool g_pending = false;
+static guint g_timeout_source = 0;
+
+// Drop being applied; wiped once CONNECTED.
+static std::string g_drop_path;
+
+/**
+ * Whole file as a string. False if missing or unreadable.
+ */
+bool read_file(const std::string& path, std::string& out)
+{
+    gchar* data = nullptr;
+    gsize len = 0;
+
+    PROVISION_BLOCKING_CALL_KNOWN("config drop read");
+    if (!g_file_get_contents(path.c_str(), &data, &len, nullptr))
+        return false;
+
+    out.assign(data, len);
+    g_free(data);
+    return true;
+}
+
+/**
+ * Overwrite with zeros, sync, unlink.
+ */
+void wipe_file(const std::string& path)
+{
+    PROVISION_BLOCKING_CALL_KNOWN("config drop wipe");
+
+    int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        struct stat st{};
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            std::vector<char> zeros(static_cast<size_t>(st.st_size), 0);
+            if (write(fd, zeros.data(), zeros.size()) < 0)
+                provision::log::warn("drop: overwrite failed: " + std::string(std::strerror(errno)));
+            fsync(fd);
+        }
+        close(fd);
+    }
+
+    if (unlink(path.c_str()) != 0 && errno != ENOENT)
+        provision::log::warn("drop: unlink " + path + " failed: " + std::strerror(errno));
+}
+
+bool equal_constant_time(const std::string& a, const std::string& b)
+{
+    if (a.size() != b.size())
+        return false;
+
+    unsigned char diff = 0;
+    for (size_t i = 0; i < a.size(); ++i)
+        diff |= static_cast<unsigned char>(a[i] ^ b[i]);
+    return diff == 0;
+}
+
+/**
+ * Check the drop against <path>.sig. Returns false if it must be rejected.
+ */
+bool verify_signature(const std::string& path, const std::string& contents)
+{
+    const bool required = provision::config::get_bool("drop", "require_signature", false);
+
+    std::string sig;
+    if (!read_file(path + ".sig", sig)) {
+        if (required) {
+            provision::log::error("drop: unsigned drop rejected (require_signature=true)");
+            return false;
+        }
+        return true;
+    }
+
+    const std::string key_file = provision::config::get_string("drop", "key_file", "");
+    std::string key;
+    if (key_file.empty() || !read_file(key_file, key)) {
+        provision::log::error("drop: signature present but no key ([drop] key_file)");
+        return false;
+    }
+
+    while (!key.empty() && (key.back() == '\n' || key.back() == '\r'))
+        key.pop_back();
+
+    gchar* mac = g_compute_hmac_for_data(
+        G_CHECKSUM_SHA256,
+        reinterpret_cast<const guchar*>(key.data()), key.size(),
+        reinterpret_cast<const guchar*>(contents.data()), contents.size());
+    const std::string expected(mac);
+    g_free(mac);
+
+    gchar* given = g_ascii_strdown(g_strstrip(&sig[0]), -1);
+    const bool ok = equal_constant_time(expected, given);
+    g_free(given);
+
+    if (!ok)
+        provision::log::error("drop: signature mismatch, drop rejected");
+    return ok;
+}
+
+void fall_back_to_ble(const std::string& why)
+{
+    if (!g_pending)
+        return;
+
+    g_pending = false;
+    if (g_timeout_source) {
+        g_source_remove(g_timeout_source);
+        g_timeout_source = 0;
+    }
+
+    provision::log::warn("drop: " + why + ", starting BLE provisioning (" +
+                         g_drop_path + " kept for the next boot)");
+    provision::bluez::set_armed(true);
+}
+
+/**
+ * The drop did its job: remove the credentials from the boot partition.
+ */
+void wipe_drop()
+{
+    const std::string path = g_drop_path;
+    std::thread([path] {
+        wipe_file(path);
+        wipe_file(path + ".sig");
+        provision::log::info("drop: wiped " + path);
+    }).detach();
+}
+
+gboolean on_drop_timeout(gpointer)
+{
+    g_timeout_source = 0;
+    fall_back_to_ble("no CONNECTED within timeout");
+    return G_SOURCE_REMOVE;
+}
+
+void on_state_event(const std::string& payload)
+{
+    if (!g_pending)
+        return;
+
+    if (payload.find("\"state\":\"CONNECTED\"") != std::string::npos) {
+        g_pending = false;
+        if (g_timeout_source) {
+            g_source_remove(g_timeout_source);
+            g_timeout_source = 0;
+        }
+        provision::log::info("drop: CONNECTED, BLE provisioning not needed");
+        wipe_drop();
+        return;
+    }
+
+    if (payload.find("\"state\":\"UNCONFIGURED\"") != std::string::npos)
+        fall_back_to_ble("connect failed");
+}
+
+} // namespace
+
+namespace provision::ctl {
+
+bool apply_config_drop()
+{
+    const std::string path = provision::config::get_string("drop", "path", CONFIG_DROP_PATH);
+
+    std::string contents;
+    if (!read_file(path, contents))
+        return false;
+
+    provision::log::info("drop: found " + path);
+
+    if (!verify_signature(path, contents))
+        return false;
+
+    g_drop_path = path;
+
+    // Disarm first: a connect that fails synchronously re-arms below.
+    g_pending = true;
+    provision::bluez::set_armed(false);
+    provision::gatt::add_state_listener(on_state_event);
+
+    const long timeout_s = provision::config::get_int("drop", "timeout_s", 90);
+    g_timeout_source = g_timeout_add_seconds(static_cast<guint>(timeout_s),
+                                             on_drop_timeout, nullptr);
+
+    // Same pipeline as a Command write, one command per line.
+    size_t applied = 0;
+    gchar** lines = g_strsplit(contents.c_str(), "\n", -1);
+    for (gchar** l = lines; l && *l; ++l) {
+        g_strstrip(*l);
+        if (**l == '\0' || **l == '#')
+            continue;
+
+        provision::gatt::dispatch_command(*l, provision::gatt::CommandSource::LOCAL);
+        ++applied;
+    }
+    g_strfreev(lines);
+
+    provision::log::info("drop: applied " + std::to_string(applied) + " command(s)");
+
+    if (applied == 0) {
+        fall_back_to_ble("drop was empty");
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace provision::ctl
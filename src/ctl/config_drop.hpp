@@ -0,0 +1,48 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   Offline configuration drop, imported at startup before BLE.
+ *
+ * Notes:
+ *   - [drop] path (default /boot/firmware/provision.json) holds one JSON
+ *     command per line, exactly as written to the Command characteristic,
+ *     e.g. {"op":"wifi_connect","ssid":"...","psk":"..."}
+ *   - Optional signature in <path>.sig: hex HMAC-SHA256 of the file with
+ *     the key in [drop] key_file. [drop] require_signature=true rejects
+ *     unsigned drops; a bad signature is always rejected
+ *   - An accepted drop is overwritten and unlinked once it has led to
+ *     CONNECTED; after a failed connect, a timeout or a crash it stays in
+ *     place and is applied again on the next start
+ *   - While it is applied the daemon stays disarmed (no advertising); if
+ *     CONNECTED is not reached within [drop] timeout_s (default 90), or
+ *     the connect fails outright, provisioning is armed as usual
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+#pragma once
+
+namespace provision::ctl {
+
+/// Default drop location (boot partition on Raspberry Pi OS).
+inline constexpr const char* CONFIG_DROP_PATH = "/boot/firmware/provision.json";
+
+/**
+ * Import and apply a config drop if one is present.
+ *
+ * Call after the GATT objects are exported and before registration;
+ * disarms registration itself while the drop is applied.
+ * Returns true if a drop was applied.
+ */
+bool apply_config_drop();
+
+} // namespace provision::ctl
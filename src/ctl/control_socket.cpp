@@ -0,0 +1,265 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   Implementation of the local control socket.
+ *
+ * Notes:
+ *   - GSocketService on the default main context; no extra threads
+ *   - Reads and writes are async so a slow client never stalls the loop
+ *   - Per-client output queue with a single write in flight keeps event
+ *     order intact
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+
+#include "ctl/control_socket.hpp"
+#include "gatt/command.hpp"
+#include "gatt/state.hpp"
+#include "util/log.hpp"
+
+#include <gio/gio.h>
+#include <gio/gunixsocketaddress.h>
+#include <glib/gstdio.h>
+
+#include <deque>
+#include <list>
+#include <string>
+
+namespace {
+
+// Queued output beyond this drops the client (it is not reading).
+constexpr size_t CLIENT_MAX_QUEUED = 256;
+
+struct Client {
+    GSocketConnection* conn{nullptr};
+    GDataInputStream* in{nullptr};
+    GOutputStream* out{nullptr};     // owned by conn
+    GCancellable* cancel{nullptr};
+
+    std::deque<std::string> outq;
+    bool reading{false};
+    bool writing{false};
+    bool closed{false};
+};
+
+static std::list<Client*> g_clients;
+static GSocketService* g_service = nullptr;
+
+void read_next(Client* c);
+void flush_client(Client* c);
+
+void destroy_client(Client* c)
+{
+    g_clients.remove(c);
+
+    g_io_stream_close(G_IO_STREAM(c->conn), nullptr, nullptr);
+    g_object_unref(c->in);
+    g_object_unref(c->conn);
+    g_object_unref(c->cancel);
+    delete c;
+
+    provision::log::info("ctl: client disconnected");
+}
+
+/**
+ * Close a client. Freed once no async operation references it.
+ */
+void close_client(Client* c)
+{
+    if (!c->closed) {
+        c->closed = true;
+        g_cancellable_cancel(c->cancel);
+    }
+
+    if (!c->reading && !c->writing)
+        destroy_client(c);
+}
+
+void on_line(GObject* source, GAsyncResult* res, gpointer user_data)
+{
+    auto* c = static_cast<Client*>(user_data);
+
+    GError* err = nullptr;
+    gsize len = 0;
+    char* line = g_data_input_stream_read_line_finish(
+        G_DATA_INPUT_STREAM(source), res, &len, &err);
+
+    if (line && !c->closed) {
+        std::string payload(line, len);
+
+        // c->reading stays set across dispatch: the State events it emits
+        // may close this client, which must not free it under us.
+        if (!payload.empty()) {
+            provision::log::info("ctl: command " + payload);
+            provision::gatt::dispatch_command(
+                payload, provision::gatt::CommandSource::LOCAL);
+        }
+    }
+
+    c->reading = false;
+
+    if (!line || c->closed) {
+        // EOF, error (including our own cancellation) or dropped meanwhile
+        if (err) g_error_free(err);
+        g_free(line);
+        close_client(c);
+        return;
+    }
+
+    g_free(line);
+    read_next(c);
+}
+
+void read_next(Client* c)
+{
+    c->reading = true;
+    g_data_input_stream_read_line_async(
+        c->in, G_PRIORITY_DEFAULT, c->cancel, on_line, c);
+}
+
+void on_written(GObject* source, GAsyncResult* res, gpointer user_data)
+{
+    auto* c = static_cast<Client*>(user_data);
+    c->writing = false;
+
+    GError* err = nullptr;
+    gboolean ok = g_output_stream_write_all_finish(
+        G_OUTPUT_STREAM(source), res, nullptr, &err);
+
+    if (!ok) {
+        if (err) g_error_free(err);
+        close_client(c);
+        return;
+    }
+
+    c->outq.pop_front();
+
+    if (c->closed) {
+        close_client(c);
+        return;
+    }
+
+    flush_client(c);
+}
+
+void flush_client(Client* c)
+{
+    if (c->writing || c->closed || c->outq.empty())
+        return;
+
+    // deque::push_back keeps references valid, so front() stays put while
+    // the write is in flight.
+    const std::string& line = c->outq.front();
+
+    c->writing = true;
+    g_output_stream_write_all_async(
+        c->out, line.data(), line.size(),
+        G_PRIORITY_DEFAULT, c->cancel, on_written, c);
+}
+
+/**
+ * State listener: fan every event out to all connected clients.
+ */
+void on_state_event(const std::string& payload)
+{
+    for (auto it = g_clients.begin(); it != g_clients.end();) {
+        Client* c = *it++;
+        if (c->closed)
+            continue;
+
+        if (c->outq.size() >= CLIENT_MAX_QUEUED) {
+            provision::log::warn("ctl: client not reading, dropping it");
+            close_client(c);
+            continue;
+        }
+
+        c->outq.push_back(payload + "\n");
+        flush_client(c);
+    }
+}
+
+gboolean on_incoming(GSocketService*,
+                     GSocketConnection* connection,
+                     GObject*,
+                     gpointer)
+{
+    auto* c = new Client;
+    c->conn = G_SOCKET_CONNECTION(g_object_ref(connection));
+    c->in = g_data_input_stream_new(
+        g_io_stream_get_input_stream(G_IO_STREAM(connection)));
+    c->out = g_io_stream_get_output_stream(G_IO_STREAM(connection));
+    c->cancel = g_cancellable_new();
+
+    g_data_input_stream_set_newline_type(c->in, G_DATA_STREAM_NEWLINE_TYPE_ANY);
+
+    g_clients.push_back(c);
+    provision::log::info("ctl: client connected");
+
+    read_next(c);
+    return TRUE;
+}
+
+} // namespace
+
+namespace provision::ctl {
+
+bool start_control_socket(const char* path)
+{
+    if (g_service)
+        return true;
+
+    gchar* dir = g_path_get_dirname(path);
+    g_mkdir_with_parents(dir, 0755);
+    g_free(dir);
+
+    // Stale socket from a previous run
+    g_unlink(path);
+
+    GSocketAddress* addr = g_unix_socket_address_new(path);
+    GSocketService* service = g_socket_service_new();
+    GError* err = nullptr;
+
+    gboolean ok = g_socket_listener_add_address(
+        G_SOCKET_LISTENER(service),
+        addr,
+        G_SOCKET_TYPE_STREAM,
+        G_SOCKET_PROTOCOL_DEFAULT,
+        nullptr,
+        nullptr,
+        &err);
+
+    g_object_unref(addr);
+
+    if (!ok) {
+        provision::log::error(
+            std::string("ctl: cannot listen on ") + path + ": " +
+            (err ? err->message : "unknown error"));
+        if (err) g_error_free(err);
+        g_object_unref(service);
+        return false;
+    }
+
+    // Root and the provisioning group only.
+    g_chmod(path, 0660);
+
+    g_signal_connect(service, "incoming", G_CALLBACK(on_incoming), nullptr);
+    g_socket_service_start(service);
+    g_service = service;
+
+    provision::gatt::add_state_listener(on_state_event);
+
+    provision::log::info(std::string("ctl: listening on ") + path);
+    return true;
+}
+
+} // namespace provision::ctl
@@ -0,0 +1,39 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   Local control socket for the provisioning engine.
+ *
+ * Notes:
+ *   - Unix domain stream socket, newline-delimited JSON both ways
+ *   - Each line written by a client is dispatched exactly like a BLE
+ *     Command write (same dispatcher, same State event stream)
+ *   - Every State event is written back to all connected clients
+ *   - Used by the provision-ctl CLI; no BLE involved
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+#pragma once
+
+namespace provision::ctl {
+
+/// Default socket path, shared with provision-ctl.
+inline constexpr const char* CONTROL_SOCKET_PATH = "/run/provision/ctl.sock";
+
+/**
+ * Start listening on the control socket on the GLib main context.
+ *
+ * Non-fatal: on failure, logs and returns false.
+ */
+bool start_control_socket(const char* path = CONTROL_SOCKET_PATH);
+
+} // namespace provision::ctl
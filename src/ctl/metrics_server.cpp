@@ -0,0 +1,273 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   Implementation of the local OpenMetrics endpoint.
+ *
+ * Notes:
+ *   - GSocketService on the default main context, like the control socket
+ *   - Per scrape: one Scrape (fixed request buffer + response string
+ *     reserved up front); rendering appends in place
+ *   - Request content is ignored; the first read only waits for the
+ *     client to have sent something, so curl sees a clean response
+ *   - Each scrape has a deadline ([metrics] timeout_ms) that cancels a
+ *     client that connects and never sends or never reads; at most
+ *     [metrics] max_scrapes run at once, further connections are closed
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+
+#include "ctl/metrics_server.hpp"
+#include "util/config.hpp"
+#include "util/log.hpp"
+#include "util/metrics.hpp"
+
+#include <gio/gio.h>
+#include <gio/gunixsocketaddress.h>
+#include <glib/gstdio.h>
+
+#include <string>
+
+namespace {
+
+constexpr size_t RESPONSE_RESERVE = 8192;
+constexpr guint LAG_INTERVAL_MS = 250;
+
+constexpr const char* RESPONSE_HEADER =
+    "HTTP/1.0 200 OK\r\n"
+    "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+    "Connection: close\r\n"
+    "\r\n";
+
+struct Scrape {
+    GSocketConnection* conn{nullptr};
+    GCancellable* cancel{nullptr};
+    guint timeout_id{0};
+    char request[1024];
+    std::string response;
+};
+
+static GSocketService* g_service = nullptr;
+static gint64 g_lag_expected_us = 0;
+
+static guint g_timeout_ms = 2000;
+static unsigned g_max_scrapes = 4;
+static unsigned g_scrapes = 0;     // in flight
+
+void finish_scrape(Scrape* s)
+{
+    if (s->timeout_id)
+        g_source_remove(s->timeout_id);
+
+    g_io_stream_close(G_IO_STREAM(s->conn), nullptr, nullptr);
+    g_object_unref(s->conn);
+    g_object_unref(s->cancel);
+    delete s;
+    --g_scrapes;
+}
+
+/**
+ * Deadline hit: cancel the pending read/write; its callback cleans up.
+ */
+gboolean on_scrape_timeout(gpointer user_data)
+{
+    auto* s = static_cast<Scrape*>(user_data);
+    s->timeout_id = 0;
+
+    provision::log::warn("metrics: scrape timed out after " +
+                         std::to_string(g_timeout_ms) + "ms");
+    g_cancellable_cancel(s->cancel);
+    return G_SOURCE_REMOVE;
+}
+
+void on_written(GObject* source, GAsyncResult* res, gpointer user_data)
+{
+    auto* s = static_cast<Scrape*>(user_data);
+
+    GError* err = nullptr;
+    if (!g_output_stream_write_all_finish(G_OUTPUT_STREAM(source), res, nullptr, &err)) {
+        provision::log::warn(std::string("metrics: write failed: ") +
+                             (err ? err->message : "unknown error"));
+        if (err) g_error_free(err);
+    }
+
+    finish_scrape(s);
+}
+
+void on_request(GObject* source, GAsyncResult* res, gpointer user_data)
+{
+    auto* s = static_cast<Scrape*>(user_data);
+
+    GError* err = nullptr;
+    gssize n = g_input_stream_read_finish(G_INPUT_STREAM(source), res, &err);
+    if (n <= 0) {
+        if (err) g_error_free(err);
+        finish_scrape(s);
+        return;
+    }
+
+    s->response.append(RESPONSE_HEADER);
+    provision::metrics::render(s->response);
+
+    g_output_stream_write_all_async(
+        g_io_stream_get_output_stream(G_IO_STREAM(s->conn)),
+        s->response.data(), s->response.size(),
+        G_PRIORITY_DEFAULT, s->cancel, on_written, s);
+}
+
+gboolean on_incoming(GSocketService*,
+                     GSocketConnection* connection,
+                     GObject*,
+                     gpointer)
+{
+    // Not referenced: the service closes it once we return.
+    if (g_scrapes >= g_max_scrapes) {
+        provision::log::warn("metrics: " + std::to_string(g_scrapes) +
+                             " scrapes in flight, connection refused");
+        return TRUE;
+    }
+
+    auto* s = new Scrape;
+    s->conn = G_SOCKET_CONNECTION(g_object_ref(connection));
+    s->cancel = g_cancellable_new();
+    s->response.reserve(RESPONSE_RESERVE);
+    s->timeout_id = g_timeout_add(g_timeout_ms, on_scrape_timeout, s);
+    ++g_scrapes;
+
+    g_input_stream_read_async(
+        g_io_stream_get_input_stream(G_IO_STREAM(connection)),
+        s->request, sizeof(s->request),
+        G_PRIORITY_DEFAULT, s->cancel, on_request, s);
+    return TRUE;
+}
+
+/**
+ * Periodic timer; how late it fires is the main-loop lag.
+ */
+gboolean on_lag_tick(gpointer)
+{
+    const gint64 now = g_get_monotonic_time();
+    const gint64 late = now - g_lag_expected_us;
+
+    provision::metrics::observe(provision::metrics::Histogram::LOOP_LAG_SECONDS,
+                                late > 0 ? late / 1e6 : 0.0);
+
+    g_lag_expected_us = now + LAG_INTERVAL_MS * 1000;
+    return G_SOURCE_CONTINUE;
+}
+
+bool listen_unix(GSocketService* service, const std::string& path)
+{
+    gchar* dir = g_path_get_dirname(path.c_str());
+    g_mkdir_with_parents(dir, 0755);
+    g_free(dir);
+
+    // Stale socket from a previous run
+    g_unlink(path.c_str());
+
+    GSocketAddress* addr = g_unix_socket_address_new(path.c_str());
+    GError* err = nullptr;
+
+    gboolean ok = g_socket_listener_add_address(
+        G_SOCKET_LISTENER(service), addr,
+        G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_DEFAULT,
+        nullptr, nullptr, &err);
+
+    g_object_unref(addr);
+
+    if (!ok) {
+        provision::log::error("metrics: cannot listen on " + path + ": " +
+                              (err ? err->message : "unknown error"));
+        if (err) g_error_free(err);
+        return false;
+    }
+
+    // Same audience as the control socket.
+    g_chmod(path.c_str(), 0660);
+
+    provision::log::info("metrics: listening on " + path);
+    return true;
+}
+
+bool listen_loopback(GSocketService* service, guint16 port)
+{
+    GInetAddress* lo = g_inet_address_new_loopback(G_SOCKET_FAMILY_IPV4);
+    GSocketAddress* addr = g_inet_socket_address_new(lo, port);
+    g_object_unref(lo);
+
+    GError* err = nullptr;
+    gboolean ok = g_socket_listener_add_address(
+        G_SOCKET_LISTENER(service), addr,
+        G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_TCP,
+        nullptr, nullptr, &err);
+
+    g_object_unref(addr);
+
+    if (!ok) {
+        provision::log::error("metrics: cannot listen on 127.0.0.1:" +
+                              std::to_string(port) + ": " +
+                              (err ? err->message : "unknown error"));
+        if (err) g_error_free(err);
+        return false;
+    }
+
+    provision::log::info("metrics: listening on 127.0.0.1:" + std::to_string(port));
+    return true;
+}
+
+} // namespace
+
+namespace provision::ctl {
+
+bool start_metrics_server()
+{
+    if (g_service)
+        return true;
+
+    if (!provision::config::get_bool("metrics", "enabled", false))
+        return false;
+
+    const std::string path =
+        provision::config::get_string("metrics", "socket", METRICS_SOCKET_PATH);
+    const long port = provision::config::get_int("metrics", "port", 0);
+
+    const long timeout_ms = provision::config::get_int("metrics", "timeout_ms", 2000);
+    if (timeout_ms > 0)
+        g_timeout_ms = static_cast<guint>(timeout_ms);
+    const long max_scrapes = provision::config::get_int("metrics", "max_scrapes", 4);
+    if (max_scrapes > 0)
+        g_max_scrapes = static_cast<unsigned>(max_scrapes);
+
+    GSocketService* service = g_socket_service_new();
+
+    bool any = false;
+    if (!path.empty())
+        any |= listen_unix(service, path);
+    if (port > 0 && port <= 65535)
+        any |= listen_loopback(service, static_cast<guint16>(port));
+
+    if (!any) {
+        g_object_unref(service);
+        return false;
+    }
+
+    g_signal_connect(service, "incoming", G_CALLBACK(on_incoming), nullptr);
+    g_socket_service_start(service);
+    g_service = service;
+
+    g_lag_expected_us = g_get_monotonic_time() + LAG_INTERVAL_MS * 1000;
+    g_timeout_add(LAG_INTERVAL_MS, on_lag_tick, nullptr);
+
+    return true;
+}
+
+} // namespace provision::ctl
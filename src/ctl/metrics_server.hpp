@@ -0,0 +1,40 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   Local OpenMetrics endpoint for fleet monitoring.
+ *
+ * Notes:
+ *   - Off unless [metrics] enabled=true
+ *   - Unix socket at [metrics] socket (default /run/provision/metrics.sock);
+ *     [metrics] port > 0 also listens on 127.0.0.1:<port>
+ *   - Minimal HTTP/1.0: any request gets the exposition, then close;
+ *     bounded by [metrics] timeout_ms and max_scrapes
+ *   - Also samples main-loop lag while enabled
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+#pragma once
+
+namespace provision::ctl {
+
+/// Default metrics socket path.
+inline constexpr const char* METRICS_SOCKET_PATH = "/run/provision/metrics.sock";
+
+/**
+ * Start the metrics endpoint on the GLib main context if enabled.
+ *
+ * Non-fatal: on failure, logs and returns false.
+ */
+bool start_metrics_server();
+
+} // namespace provision::ctl
@@ -0,0 +1,272 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   provision-ctl: command-line client for the local control socket.
+ *
+ * Usage:
+ *   provision-ctl [-s socket] [-t timeout_s] scan
+ *   provision-ctl [-s socket] [-t timeout_s] connect <ssid> [psk]
+ *   provision-ctl [-s socket] [-t timeout_s] status
+ *   provision-ctl [-s socket] [-t timeout_s] send '<json>'
+ *   provision-ctl [-s socket] watch
+ *
+ * Notes:
+ *   - Prints State events (one JSON object per line) as they arrive
+ *   - Exits 0 once the command reached its terminal state, 1 on failure
+ *     or timeout, 2 on usage errors
+ *   - Plain POSIX; no GLib so it stays usable from minimal shells
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+
+#include "ctl/control_socket.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+enum class Wait {
+    SCAN,     // until SCAN_COMPLETE
+    CONNECT,  // until CONNECTED (success) or UNCONFIGURED (failure)
+    STATUS,   // first state event
+    NONE,     // send only
+    FOREVER   // watch
+};
+
+void usage()
+{
+    std::fprintf(stderr,
+        "usage: provision-ctl [-s socket] [-t timeout_s] <command>\n"
+        "  scan                  scan for Wi-Fi networks\n"
+        "  connect <ssid> [psk]  connect to a network\n"
+        "  status                print the current state\n"
+        "  send '<json>'         send a raw command\n"
+        "  watch                 print State events until interrupted\n");
+}
+
+std::string json_escape(const std::string& in)
+{
+    std::string out;
+    out.reserve(in.size());
+
+    for (char c : in) {
+        switch (c) {
+        case '\\': out += "\\\\"; break;
+        case '"':  out += "\\\""; break;
+        case '\n': out += "\\n";  break;
+        case '\r': out += "\\r";  break;
+        case '\t': out += "\\t";  break;
+        default:
+            if ((unsigned char)c < 0x20) out += '?';
+            else out += c;
+        }
+    }
+    return out;
+}
+
+bool has_state(const std::string& line, const char* state)
+{
+    return line.find(std::string("\"state\":\"") + state + "\"") != std::string::npos;
+}
+
+/**
+ * Return 0 (done, success), 1 (done, failure) or -1 (keep waiting).
+ */
+int check_terminal(Wait wait, const std::string& line)
+{
+    switch (wait) {
+    case Wait::SCAN:
+        return has_state(line, "SCAN_COMPLETE") ? 0 : -1;
+    case Wait::CONNECT:
+        if (has_state(line, "CONNECTED"))
+            return 0;
+        if (has_state(line, "UNCONFIGURED"))
+            return 1;
+        return -1;
+    case Wait::STATUS:
+        return line.find("\"state\"") != std::string::npos ? 0 : -1;
+    case Wait::NONE:
+        return 0;
+    case Wait::FOREVER:
+        return -1;
+    }
+    return -1;
+}
+
+int connect_socket(const char* path)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool write_all(int fd, const std::string& data)
+{
+    size_t off = 0;
+    while (off < data.size()) {
+        ssize_t n = write(fd, data.data() + off, data.size() - off);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        off += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const char* path = provision::ctl::CONTROL_SOCKET_PATH;
+    int timeout_s = 60;
+
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-'; ++i) {
+        if (std::strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            path = argv[++i];
+        } else if (std::strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            timeout_s = std::atoi(argv[++i]);
+        } else {
+            usage();
+            return 2;
+        }
+    }
+
+    if (i >= argc) {
+        usage();
+        return 2;
+    }
+
+    const std::string cmd = argv[i++];
+    std::string request;
+    Wait wait = Wait::NONE;
+
+    if (cmd == "scan") {
+        request = "{\"op\":\"wifi_scan\"}";
+        wait = Wait::SCAN;
+    } else if (cmd == "connect" && i < argc) {
+        std::string ssid = argv[i++];
+        std::string psk = i < argc ? argv[i++] : "";
+        request = "{\"op\":\"wifi_connect\",\"ssid\":\"" + json_escape(ssid) +
+                  "\",\"psk\":\"" + json_escape(psk) + "\"}";
+        wait = Wait::CONNECT;
+    } else if (cmd == "status") {
+        request = "{\"op\":\"status\"}";
+        wait = Wait::STATUS;
+    } else if (cmd == "send" && i < argc) {
+        request = argv[i++];
+        wait = Wait::NONE;
+    } else if (cmd == "watch") {
+        wait = Wait::FOREVER;
+    } else {
+        usage();
+        return 2;
+    }
+
+    int fd = connect_socket(path);
+    if (fd < 0) {
+        std::fprintf(stderr, "provision-ctl: cannot connect to %s: %s\n",
+                     path, std::strerror(errno));
+        return 1;
+    }
+
+    if (!request.empty() && !write_all(fd, request + "\n")) {
+        std::fprintf(stderr, "provision-ctl: write failed: %s\n", std::strerror(errno));
+        close(fd);
+        return 1;
+    }
+
+    if (wait == Wait::NONE) {
+        close(fd);
+        return 0;
+    }
+
+    using clock = std::chrono::steady_clock;
+    const auto deadline = clock::now() + std::chrono::seconds(timeout_s);
+
+    std::string pending;
+    char buf[4096];
+    int rc = 1;
+
+    while (true) {
+        int wait_ms = -1;
+        if (wait != Wait::FOREVER) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - clock::now()).count();
+            if (left <= 0) {
+                std::fprintf(stderr, "provision-ctl: timed out\n");
+                break;
+            }
+            wait_ms = static_cast<int>(left);
+        }
+
+        pollfd pfd{fd, POLLIN, 0};
+        int pr = poll(&pfd, 1, wait_ms);
+        if (pr < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (pr == 0)
+            continue;
+
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n <= 0) {
+            std::fprintf(stderr, "provision-ctl: daemon closed the connection\n");
+            break;
+        }
+        pending.append(buf, static_cast<size_t>(n));
+
+        size_t nl;
+        int done = -1;
+        while (done < 0 && (nl = pending.find('\n')) != std::string::npos) {
+            std::string line = pending.substr(0, nl);
+            pending.erase(0, nl + 1);
+
+            std::printf("%s\n", line.c_str());
+            std::fflush(stdout);
+
+            done = check_terminal(wait, line);
+        }
+
+        if (done >= 0) {
+            rc = done;
+            break;
+        }
+    }
+
+    close(fd);
+    return rc;
+}
@@ -0,0 +1,338 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   Implementation of async adapter power-up.
+ *
+ * Notes:
+ *   - Replaces the rfkill/btmgmt/sleep steps that setupenv.sh ran once
+ *     at install time, so a reboot or bluetoothd restart is handled too
+ *   - The PropertiesChanged subscription is made before reading Powered,
+ *     so the transition can not be missed
+ *   - rfkill is host-wide, so it is left alone with [wifi] backend=sim or
+ *     a fixed [adapter] path (fleet simulator, stand-in BlueZ)
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+
+#include "dbus/adapter_power.hpp"
+#include "util/config.hpp"
+#include "util/log.hpp"
+#include "wifi/sim_backend.hpp"
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <linux/rfkill.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr const char* BLUEZ_BUS = "org.bluez";
+constexpr const char* PROPS_IFACE = "org.freedesktop.DBus.Properties";
+constexpr const char* ADAPTER_IFACE = "org.bluez.Adapter1";
+
+struct PowerCtx {
+    GDBusConnection* bus{nullptr};   // not owned
+    std::string adapter_path;
+    provision::bluez::AdapterReadyCallback cb;
+
+    guint signal_id{0};
+    guint timeout_id{0};
+    int pending{0};                  // async calls + live subscription
+    bool done{false};
+};
+
+/**
+ * False when this instance must not touch the host's radios: simulated
+ * Wi-Fi or a pinned adapter means we are not the only daemon on the host.
+ */
+bool owns_host_radio()
+{
+    return !provision::wifi::sim_backend_enabled() &&
+           provision::config::get_string("adapter", "path", "").empty();
+}
+
+void maybe_free(PowerCtx* ctx)
+{
+    if (ctx->done && ctx->pending == 0)
+        delete ctx;
+}
+
+/**
+ * Clear the soft block on all Bluetooth radios (rfkill unblock bluetooth).
+ * Non-blocking write to /dev/rfkill; needs CAP_NET_ADMIN.
+ */
+void rfkill_unblock_bluetooth()
+{
+    int fd = open("/dev/rfkill", O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        provision::log::warn(std::string("adapter: cannot open /dev/rfkill: ") +
+                             std::strerror(errno));
+        return;
+    }
+
+    rfkill_event ev{};
+    ev.type = RFKILL_TYPE_BLUETOOTH;
+    ev.op = RFKILL_OP_CHANGE_ALL;
+    ev.soft = 0;
+
+    if (write(fd, &ev, sizeof(ev)) < 0) {
+        provision::log::warn(std::string("adapter: rfkill unblock failed: ") +
+                             std::strerror(errno));
+    }
+
+    close(fd);
+}
+
+void on_set_logged(GObject* source, GAsyncResult* res, gpointer user_data)
+{
+    const char* prop = static_cast<const char*>(user_data);
+
+    GError* err = nullptr;
+    GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), res, &err);
+
+    if (reply) {
+        g_variant_unref(reply);
+        return;
+    }
+
+    provision::log::warn(std::string("adapter: setting ") + prop + " failed: " +
+                         (err && err->message ? err->message : "unknown error"));
+    if (err) g_error_free(err);
+}
+
+/**
+ * Fire-and-forget Adapter1 property write. prop must be a string literal.
+ */
+void set_adapter_prop(GDBusConnection* bus,
+                      const std::string& adapter_path,
+                      const char* prop,
+                      GVariant* value)
+{
+    g_dbus_connection_call(
+        bus,
+        BLUEZ_BUS,
+        adapter_path.c_str(),
+        PROPS_IFACE,
+        "Set",
+        g_variant_new("(ssv)", ADAPTER_IFACE, prop, value),
+        nullptr,
+        G_DBUS_CALL_FLAGS_NONE,
+        -1,
+        nullptr,
+        on_set_logged,
+        const_cast<char*>(prop)
+    );
+}
+
+void finish(PowerCtx* ctx, bool ok, const std::string& err)
+{
+    if (ctx->done)
+        return;
+
+    ctx->done = true;
+
+    // Hold ctx across a destroy notify that may run inside unsubscribe.
+    ++ctx->pending;
+
+    if (ctx->timeout_id) {
+        g_source_remove(ctx->timeout_id);
+        ctx->timeout_id = 0;
+    }
+    if (ctx->signal_id) {
+        // Destroy notify drops the subscription's pending count.
+        g_dbus_connection_signal_unsubscribe(ctx->bus, ctx->signal_id);
+        ctx->signal_id = 0;
+    }
+
+    if (ok) {
+        provision::log::info("adapter: " + ctx->adapter_path + " powered");
+
+        if (provision::config::get_bool("adapter", "discoverable", true)) {
+            set_adapter_prop(ctx->bus, ctx->adapter_path,
+                             "DiscoverableTimeout", g_variant_new_uint32(0));
+            set_adapter_prop(ctx->bus, ctx->adapter_path,
+                             "Discoverable", g_variant_new_boolean(TRUE));
+            set_adapter_prop(ctx->bus, ctx->adapter_path,
+                             "Pairable", g_variant_new_boolean(TRUE));
+        }
+    } else {
+        provision::log::error("adapter: " + ctx->adapter_path + " not ready: " + err);
+    }
+
+    // Callers release ctx (maybe_free) after this returns.
+    auto cb = std::move(ctx->cb);
+    --ctx->pending;
+    cb(ok, err);
+}
+
+void on_subscription_gone(gpointer user_data)
+{
+    auto* ctx = static_cast<PowerCtx*>(user_data);
+    --ctx->pending;
+    maybe_free(ctx);
+}
+
+void on_adapter_props(GDBusConnection*,
+                      const gchar*,
+                      const gchar*,
+                      const gchar*,
+                      const gchar*,
+                      GVariant* parameters,
+                      gpointer user_data)
+{
+    auto* ctx = static_cast<PowerCtx*>(user_data);
+
+    GVariant* changed = nullptr;
+    g_variant_get(parameters, "(&s@a{sv}@as)", nullptr, &changed, nullptr);
+    if (!changed)
+        return;
+
+    gboolean powered = FALSE;
+    if (g_variant_lookup(changed, "Powered", "b", &powered) && powered)
+        finish(ctx, true, {});
+
+    g_variant_unref(changed);
+    maybe_free(ctx);
+}
+
+gboolean on_timeout(gpointer user_data)
+{
+    auto* ctx = static_cast<PowerCtx*>(user_data);
+    ctx->timeout_id = 0;
+    finish(ctx, false, "timed out waiting for Powered");
+    maybe_free(ctx);
+    return G_SOURCE_REMOVE;
+}
+
+void on_powered_set(GObject* source, GAsyncResult* res, gpointer user_data)
+{
+    auto* ctx = static_cast<PowerCtx*>(user_data);
+    --ctx->pending;
+
+    GError* err = nullptr;
+    GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), res, &err);
+
+    if (reply) {
+        g_variant_unref(reply);
+        // Now wait for PropertiesChanged(Powered=true).
+        maybe_free(ctx);
+        return;
+    }
+
+    std::string msg = err && err->message ? err->message : "unknown error";
+    if (err) g_error_free(err);
+
+    finish(ctx, false, "Set Powered failed: " + msg);
+    maybe_free(ctx);
+}
+
+void on_powered_get(GObject* source, GAsyncResult* res, gpointer user_data)
+{
+    auto* ctx = static_cast<PowerCtx*>(user_data);
+    --ctx->pending;
+
+    GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), res, nullptr);
+
+    gboolean powered = FALSE;
+    if (reply) {
+        GVariant* v = nullptr;
+        g_variant_get(reply, "(v)", &v);
+        if (v && g_variant_is_of_type(v, G_VARIANT_TYPE_BOOLEAN))
+            powered = g_variant_get_boolean(v);
+        if (v) g_variant_unref(v);
+        g_variant_unref(reply);
+    }
+
+    if (ctx->done) {
+        maybe_free(ctx);
+        return;
+    }
+
+    if (powered) {
+        finish(ctx, true, {});
+        maybe_free(ctx);
+        return;
+    }
+
+    provision::log::info("adapter: " + ctx->adapter_path + " is off, powering on");
+
+    ++ctx->pending;
+    g_dbus_connection_call(
+        ctx->bus,
+        BLUEZ_BUS,
+        ctx->adapter_path.c_str(),
+        PROPS_IFACE,
+        "Set",
+        g_variant_new("(ssv)", ADAPTER_IFACE, "Powered", g_variant_new_boolean(TRUE)),
+        nullptr,
+        G_DBUS_CALL_FLAGS_NONE,
+        -1,
+        nullptr,
+        on_powered_set,
+        ctx
+    );
+}
+
+} // namespace
+
+namespace provision::bluez {
+
+void ensure_adapter_ready_async(GDBusConnection* system_bus,
+                                const std::string& adapter_path,
+                                AdapterReadyCallback cb)
+{
+    if (owns_host_radio())
+        rfkill_unblock_bluetooth();
+
+    auto* ctx = new PowerCtx;
+    ctx->bus = system_bus;
+    ctx->adapter_path = adapter_path;
+    ctx->cb = std::move(cb);
+
+    ++ctx->pending;
+    ctx->signal_id = g_dbus_connection_signal_subscribe(
+        system_bus,
+        BLUEZ_BUS,
+        PROPS_IFACE,
+        "PropertiesChanged",
+        adapter_path.c_str(),
+        ADAPTER_IFACE,
+        G_DBUS_SIGNAL_FLAGS_NONE,
+        on_adapter_props,
+        ctx,
+        on_subscription_gone
+    );
+
+    const long timeout_s = provision::config::get_int("adapter", "power_timeout_s", 10);
+    ctx->timeout_id = g_timeout_add_seconds(static_cast<guint>(timeout_s), on_timeout, ctx);
+
+    ++ctx->pending;
+    g_dbus_connection_call(
+        system_bus,
+        BLUEZ_BUS,
+        adapter_path.c_str(),
+        PROPS_IFACE,
+        "Get",
+        g_variant_new("(ss)", ADAPTER_IFACE, "Powered"),
+        G_VARIANT_TYPE("(v)"),
+        G_DBUS_CALL_FLAGS_NONE,
+        -1,
+        nullptr,
+        on_powered_get,
+        ctx
+    );
+}
+
+} // namespace provision::bluez
@@ -0,0 +1,46 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   Bring the Bluetooth controller up without external scripts.
+ *
+ * Notes:
+ *   - Clears the rfkill soft block, sets Adapter1.Powered and waits for
+ *     the PropertiesChanged signal instead of sleeping
+ *   - Optionally makes the adapter discoverable/pairable
+ *     ([adapter] discoverable, default true)
+ *   - Everything is async on the main context
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+#include <functional>
+#include <string>
+
+namespace provision::bluez {
+
+using AdapterReadyCallback = std::function<void(bool ready, const std::string& error)>;
+
+/**
+ * Ensure adapter_path is unblocked and powered.
+ *
+ * cb runs exactly once: (true, "") as soon as Powered is true, or
+ * (false, reason) after [adapter] power_timeout_s (default 10).
+ */
+void ensure_adapter_ready_async(GDBusConnection* system_bus,
+                                const std::string& adapter_path,
+                                AdapterReadyCallback cb);
+
+} // namespace provision::bluez
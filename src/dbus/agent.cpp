@@ -0,0 +1,483 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   Implementation of the built-in org.bluez.Agent1 pairing agent.
+ *
+ * Notes:
+ *   - All D-Bus calls are async; the agent never blocks the main loop
+ *   - Bond tracking is driven by Device1 "Paired" changes, so bonds
+ *     completed without an agent callback (Just-Works) are caught too
+ *   - Only bonds made while provisioning is armed count, and never a
+ *     device that was already paired when bluetoothd was last seen
+ *     appearing (keyboards, remotes ...)
+ *   - Passkey mode is display-only: the kernel generates the LE SC key
+ *     per pairing and it is written to the log; there is no fixed key
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+
+#include "dbus/agent.hpp"
+#include "dbus/registration.hpp"
+#include "util/config.hpp"
+#include "util/log.hpp"
+
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+
+namespace {
+
+constexpr const char* BLUEZ_BUS = "org.bluez";
+constexpr const char* AGENT_MGR_IFACE = "org.bluez.AgentManager1";
+constexpr const char* ADAPTER_IFACE = "org.bluez.Adapter1";
+constexpr const char* DEVICE_IFACE = "org.bluez.Device1";
+
+enum class AgentMode {
+    JUST_WORKS,
+    PASSKEY,
+    NONE
+};
+
+static GDBusConnection* g_bus = nullptr;   // not owned
+static AgentMode g_mode = AgentMode::JUST_WORKS;
+static bool g_exported = false;            // agent object on the bus
+
+// Devices that bonded during this provisioning window.
+static std::set<std::string> g_bonded;
+
+// Devices already paired before it; never purged.
+static std::set<std::string> g_preexisting;
+
+static guint g_purge_source = 0;
+
+// Connect timestamps (monotonic us) awaiting ServicesResolved.
+static std::map<std::string, gint64> g_connect_started;
+
+const char* XML_AGENT = R"XML(
+<node>
+  <interface name="org.bluez.Agent1">
+    <method name="Release"/>
+    <method name="RequestPinCode">
+      <arg name="device" type="o" direction="in"/>
+      <arg name="pincode" type="s" direction="out"/>
+    </method>
+    <method name="DisplayPinCode">
+      <arg name="device" type="o" direction="in"/>
+      <arg name="pincode" type="s" direction="in"/>
+    </method>
+    <method name="RequestPasskey">
+      <arg name="device" type="o" direction="in"/>
+      <arg name="passkey" type="u" direction="out"/>
+    </method>
+    <method name="DisplayPasskey">
+      <arg name="device" type="o" direction="in"/>
+      <arg name="passkey" type="u" direction="in"/>
+      <arg name="entered" type="q" direction="in"/>
+    </method>
+    <method name="RequestConfirmation">
+      <arg name="device" type="o" direction="in"/>
+      <arg name="passkey" type="u" direction="in"/>
+    </method>
+    <method name="RequestAuthorization">
+      <arg name="device" type="o" direction="in"/>
+    </method>
+    <method name="AuthorizeService">
+      <arg name="device" type="o" direction="in"/>
+      <arg name="uuid" type="s" direction="in"/>
+    </method>
+    <method name="Cancel"/>
+  </interface>
+</node>
+)XML";
+
+const char* capability_for(AgentMode mode)
+{
+    return mode == AgentMode::PASSKEY ? "DisplayOnly" : "NoInputNoOutput";
+}
+
+void reject(GDBusMethodInvocation* invocation, const char* why)
+{
+    g_dbus_method_invocation_return_dbus_error(
+        invocation, "org.bluez.Error.Rejected", why);
+}
+
+std::string first_path_arg(GVariant* parameters)
+{
+    const char* device = nullptr;
+    g_variant_get_child(parameters, 0, "&o", &device);
+    return device ? device : "";
+}
+
+void on_method_call(GDBusConnection*,
+                    const gchar*,
+                    const gchar*,
+                    const gchar*,
+                    const gchar* method,
+                    GVariant* parameters,
+                    GDBusMethodInvocation* invocation,
+                    gpointer)
+{
+    const std::string m(method);
+
+    if (m == "Release" || m == "Cancel") {
+        provision::log::info("agent: " + m);
+        g_dbus_method_invocation_return_value(invocation, nullptr);
+        return;
+    }
+
+    const std::string device = first_path_arg(parameters);
+
+    if (m == "RequestPinCode" || m == "RequestPasskey") {
+        // We advertise no input capability, so there is nothing to type in.
+        provision::log::warn("agent: " + m + " rejected " + device);
+        reject(invocation, "No input capability");
+        return;
+    }
+
+    if (m == "DisplayPasskey" || m == "DisplayPinCode") {
+        // Headless: the log (serial console / factory line) is our display.
+        std::string shown;
+        if (m == "DisplayPasskey") {
+            guint32 passkey = 0;
+            guint16 entered = 0;
+            g_variant_get(parameters, "(&ouq)", nullptr, &passkey, &entered);
+            char buf[7]{};
+            g_snprintf(buf, sizeof(buf), "%06u", passkey);
+            shown = buf;
+        } else {
+            const char* pin = nullptr;
+            g_variant_get(parameters, "(&o&s)", nullptr, &pin);
+            shown = pin ? pin : "";
+        }
+        provision::log::info("agent: pairing code for " + device + ": " + shown);
+        g_dbus_method_invocation_return_value(invocation, nullptr);
+        return;
+    }
+
+    if (m == "RequestConfirmation") {
+        // Just-Works: nothing to compare against. Passkey mode: DisplayOnly
+        // never gets numeric comparison, so a request here means the key
+        // display was skipped.
+        if (g_mode == AgentMode::PASSKEY) {
+            provision::log::warn("agent: RequestConfirmation rejected " + device);
+            reject(invocation, "Passkey required");
+            return;
+        }
+        provision::log::info("agent: RequestConfirmation accepted " + device);
+        g_dbus_method_invocation_return_value(invocation, nullptr);
+        return;
+    }
+
+    if (m == "RequestAuthorization" || m == "AuthorizeService") {
+        // Both skip key entry entirely; passkey mode must not allow that.
+        if (g_mode == AgentMode::PASSKEY) {
+            provision::log::warn("agent: " + m + " rejected " + device);
+            reject(invocation, "Passkey required");
+            return;
+        }
+        provision::log::info("agent: " + m + " accepted " + device);
+        g_dbus_method_invocation_return_value(invocation, nullptr);
+        return;
+    }
+
+    g_dbus_method_invocation_return_dbus_error(
+        invocation,
+        "org.freedesktop.DBus.Error.UnknownMethod",
+        "Unknown method"
+    );
+}
+
+const GDBusInterfaceVTable AGENT_VTABLE = {
+    on_method_call,
+    nullptr,
+    nullptr,
+    {0}
+};
+
+/**
+ * Device1 PropertiesChanged: bond tracking and link-ready timing.
+ */
+void on_device_props(GDBusConnection*,
+                     const gchar*,
+                     const gchar* object_path,
+                     const gchar*,
+                     const gchar*,
+                     GVariant* parameters,
+                     gpointer)
+{
+    const char* iface = nullptr;
+    GVariant* changed = nullptr;
+    g_variant_get(parameters, "(&s@a{sv}@as)", &iface, &changed, nullptr);
+    if (!changed)
+        return;
+
+    const std::string device(object_path);
+    gboolean b = FALSE;
+
+    if (g_variant_lookup(changed, "Paired", "b", &b)) {
+        if (!b) {
+            g_bonded.erase(device);
+            g_preexisting.erase(device);
+        } else if (!g_preexisting.count(device) && provision::bluez::is_armed()) {
+            if (g_bonded.insert(device).second)
+                provision::log::info("agent: bonded " + device);
+        }
+    }
+
+    if (g_variant_lookup(changed, "Connected", "b", &b)) {
+        if (b)
+            g_connect_started[device] = g_get_monotonic_time();
+        else
+            g_connect_started.erase(device);
+    }
+
+    if (g_variant_lookup(changed, "ServicesResolved", "b", &b) && b) {
+        auto it = g_connect_started.find(device);
+        if (it != g_connect_started.end()) {
+            gint64 ms = (g_get_monotonic_time() - it->second) / 1000;
+            g_connect_started.erase(it);
+
+            provision::log::info(
+                "agent: link ready device=" + device +
+                " ms=" + std::to_string(ms) +
+                " bonded=" + (g_bonded.count(device) ? "yes" : "no"));
+        }
+    }
+
+    g_variant_unref(changed);
+}
+
+void on_call_logged(GObject* source, GAsyncResult* res, gpointer user_data)
+{
+    std::unique_ptr<std::string> what(static_cast<std::string*>(user_data));
+
+    GError* err = nullptr;
+    GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), res, &err);
+
+    if (reply) {
+        g_variant_unref(reply);
+        provision::log::info("agent: " + *what + " ok");
+        return;
+    }
+
+    provision::log::warn("agent: " + *what + " failed: " +
+                         (err && err->message ? err->message : "unknown error"));
+    if (err) g_error_free(err);
+}
+
+void call_logged(const char* path,
+                 const char* iface,
+                 const char* method,
+                 GVariant* args,
+                 const std::string& what)
+{
+    g_dbus_connection_call(
+        g_bus,
+        BLUEZ_BUS,
+        path,
+        iface,
+        method,
+        args,
+        nullptr,
+        G_DBUS_CALL_FLAGS_NONE,
+        -1,
+        nullptr,
+        on_call_logged,
+        new std::string(what)
+    );
+}
+
+/**
+ * GetManagedObjects reply: remember every device that is paired right
+ * now and was not bonded by us.
+ */
+void on_existing_bonds(GObject* source, GAsyncResult* res, gpointer)
+{
+    GError* err = nullptr;
+    GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), res, &err);
+    if (!reply) {
+        provision::log::warn(std::string("agent: listing existing bonds failed: ") +
+                             (err && err->message ? err->message : "unknown error"));
+        if (err) g_error_free(err);
+        return;
+    }
+
+    GVariantIter* objects = nullptr;
+    g_variant_get(reply, "(a{oa{sa{sv}}})", &objects);
+
+    const char* path = nullptr;
+    GVariant* ifaces = nullptr;
+    while (g_variant_iter_next(objects, "{&o@a{sa{sv}}}", &path, &ifaces)) {
+        GVariant* props = g_variant_lookup_value(ifaces, DEVICE_IFACE, G_VARIANT_TYPE("a{sv}"));
+        gboolean paired = FALSE;
+
+        if (props && g_variant_lookup(props, "Paired", "b", &paired) && paired &&
+            !g_bonded.count(path))
+            g_preexisting.insert(path);
+
+        if (props)
+            g_variant_unref(props);
+        g_variant_unref(ifaces);
+    }
+
+    g_variant_iter_free(objects);
+    g_variant_unref(reply);
+
+    provision::log::info("agent: " + std::to_string(g_preexisting.size()) +
+                         " existing bond(s) will be kept");
+}
+
+gboolean on_purge_bonds(gpointer)
+{
+    for (const auto& device : g_bonded) {
+        // /org/bluez/hci0/dev_XX -> /org/bluez/hci0
+        const std::string adapter = device.substr(0, device.rfind('/'));
+
+        call_logged(adapter.c_str(),
+                    ADAPTER_IFACE,
+                    "RemoveDevice",
+                    g_variant_new("(o)", device.c_str()),
+                    "RemoveDevice " + device);
+    }
+
+    g_bonded.clear();
+    g_purge_source = 0;
+    return G_SOURCE_REMOVE;
+}
+
+} // namespace
+
+namespace provision::bluez {
+
+void start_agent(GDBusConnection* system_bus)
+{
+    g_bus = system_bus;
+
+    const std::string mode = provision::config::get_string("agent", "mode", "just-works");
+    if (mode == "passkey")
+        g_mode = AgentMode::PASSKEY;
+    else if (mode == "none")
+        g_mode = AgentMode::NONE;
+    else
+        g_mode = AgentMode::JUST_WORKS;
+
+    // LE SC passkeys are generated by the displaying side per pairing, so
+    // a fixed key could never be used.
+    if (!provision::config::get_string("agent", "passkey", "").empty())
+        provision::log::warn("agent: [agent] passkey is not supported, ignored");
+
+    // Bond tracking and timing are useful even without our agent.
+    g_dbus_connection_signal_subscribe(
+        system_bus,
+        BLUEZ_BUS,
+        "org.freedesktop.DBus.Properties",
+        "PropertiesChanged",
+        nullptr,
+        DEVICE_IFACE,
+        G_DBUS_SIGNAL_FLAGS_NONE,
+        on_device_props,
+        nullptr,
+        nullptr
+    );
+
+    if (g_mode == AgentMode::NONE) {
+        provision::log::info("agent: disabled by config");
+        return;
+    }
+
+    GError* err = nullptr;
+    GDBusNodeInfo* node = g_dbus_node_info_new_for_xml(XML_AGENT, &err);
+    if (!node) {
+        provision::log::error(std::string("agent: XML error: ") +
+                              (err ? err->message : "unknown error"));
+        if (err) g_error_free(err);
+        return;
+    }
+
+    guint id = g_dbus_connection_register_object(
+        system_bus,
+        AGENT_PATH,
+        node->interfaces[0],
+        &AGENT_VTABLE,
+        nullptr,
+        nullptr,
+        &err
+    );
+
+    g_dbus_node_info_unref(node);
+
+    if (id == 0) {
+        provision::log::error(std::string("agent: export failed: ") +
+                              (err ? err->message : "unknown error"));
+        if (err) g_error_free(err);
+        return;
+    }
+
+    g_exported = true;
+}
+
+void register_agent()
+{
+    // Whatever is paired before this bluetoothd sees a client is not ours.
+    g_dbus_connection_call(
+        g_bus,
+        BLUEZ_BUS,
+        "/",
+        "org.freedesktop.DBus.ObjectManager",
+        "GetManagedObjects",
+        nullptr,
+        G_VARIANT_TYPE("(a{oa{sa{sv}}})"),
+        G_DBUS_CALL_FLAGS_NONE,
+        -1,
+        nullptr,
+        on_existing_bonds,
+        nullptr
+    );
+
+    if (!g_exported)
+        return;
+
+    call_logged("/org/bluez",
+                AGENT_MGR_IFACE,
+                "RegisterAgent",
+                g_variant_new("(os)", AGENT_PATH, capability_for(g_mode)),
+                std::string("RegisterAgent ") + capability_for(g_mode));
+
+    // Queued after RegisterAgent on the same connection, so ordered.
+    call_logged("/org/bluez",
+                AGENT_MGR_IFACE,
+                "RequestDefaultAgent",
+                g_variant_new("(o)", AGENT_PATH),
+                "RequestDefaultAgent");
+}
+
+void schedule_bond_purge()
+{
+    if (!provision::config::get_bool("agent", "purge_bonds", true))
+        return;
+
+    if (g_bonded.empty() || g_purge_source != 0)
+        return;
+
+    const long delay_s = provision::config::get_int("agent", "purge_delay_s", 30);
+    provision::log::info(
+        "agent: purging " + std::to_string(g_bonded.size()) +
+        " bond(s) in " + std::to_string(delay_s) + "s");
+
+    g_purge_source = g_timeout_add_seconds(
+        static_cast<guint>(delay_s), on_purge_bonds, nullptr);
+}
+
+} // namespace provision::bluez
@@ -0,0 +1,66 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   Built-in BlueZ pairing agent (org.bluez.Agent1).
+ *
+ * Notes:
+ *   - Registered as the default agent so pairing never depends on
+ *     whatever bluetoothd falls back to without one
+ *   - Policy from config [agent] mode:
+ *       just-works (default) - NoInputNoOutput, every request accepted
+ *       passkey              - DisplayOnly; the kernel generates the key
+ *                              per pairing and it is written to the log
+ *                              (no fixed key); requests that skip key
+ *                              entry are rejected
+ *       none                 - no agent registered
+ *   - Devices bonded while provisioning is armed are tracked and removed
+ *     again once provisioning is done; bonds that already existed are
+ *     left alone
+ *   - Logs link-ready time per connection, split by bonded / not bonded
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+namespace provision::bluez {
+
+inline constexpr const char* AGENT_PATH = "/org/bluez/provision/agent";
+
+/**
+ * Export the agent object and start bond tracking.
+ *
+ * Reads the [agent] config section. Errors are logged, never fatal:
+ * without our agent BlueZ falls back to its own default behaviour.
+ */
+void start_agent(GDBusConnection* system_bus);
+
+/**
+ * Register the exported agent with AgentManager1 and make it the
+ * default (async), and snapshot the bonds that exist at this point so
+ * the purge never touches them. Must be repeated every time bluetoothd
+ * (re)appears. Registration is skipped if the agent is disabled or was
+ * not exported.
+ */
+void register_agent();
+
+/**
+ * Remove the bonds created during this provisioning window after
+ * [agent] purge_delay_s, giving the client time to read the final state.
+ * No-op if [agent] purge_bonds=false.
+ */
+void schedule_bond_purge();
+
+} // namespace provision::bluez
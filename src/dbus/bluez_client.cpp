@@ -17,7 +17,9 @@
  */
 
 #include "dbus/bluez_client.hpp"
+#include "util/config.hpp"
 #include "util/log.hpp"
+#include "util/blocking_probe.hpp"
 
 #include <stdexcept>
 #include <string>
@@ -53,10 +55,80 @@ std::runtime_error make_error(const std::string& prefix, GError* err)
     return std::runtime_error(msg);
 }
 
+/**
+ * Pick the first adapter exposing both GattManager1 and
+ * LEAdvertisingManager1 from a GetManagedObjects reply. Empty if none.
+ * [adapter] path, if set, restricts the choice to that adapter.
+ */
+std::string select_adapter(GVariant* reply)
+{
+    const std::string wanted = provision::config::get_string("adapter", "path", "");
+
+    GVariant* objects = nullptr;
+    g_variant_get(reply, "(@a{oa{sa{sv}}})", &objects);
+
+    std::string adapter_path;
+    GVariantIter outer;
+    const char* obj_path = nullptr;
+    GVariant* iface_dict = nullptr;
+
+    g_variant_iter_init(&outer, objects);
+    while (g_variant_iter_next(&outer, "{&o@a{sa{sv}}}", &obj_path, &iface_dict)) {
+        bool has_gatt = has_interface(iface_dict, GATT_MGR_IFACE);
+        bool has_adv  = has_interface(iface_dict, ADV_MGR_IFACE);
+        g_variant_unref(iface_dict);
+
+        if (has_gatt && has_adv && (wanted.empty() || wanted == obj_path)) {
+            adapter_path = obj_path;
+            break;
+        }
+    }
+
+    g_variant_unref(objects);
+    return adapter_path;
+}
+
 struct AsyncCtx {
     provision::bluez::RegisterCallback cb;
 };
 
+struct FindAdapterCtx {
+    provision::bluez::AdapterCallback cb;
+};
+
+void on_managed_objects(GObject* source_object,
+                        GAsyncResult* res,
+                        gpointer user_data)
+{
+    std::unique_ptr<FindAdapterCtx> ctx(static_cast<FindAdapterCtx*>(user_data));
+
+    GError* err = nullptr;
+    GVariant* reply = g_dbus_connection_call_finish(
+        G_DBUS_CONNECTION(source_object),
+        res,
+        &err
+    );
+
+    if (!reply) {
+        std::string msg = (err && err->message) ? err->message : "unknown error";
+        if (err) g_error_free(err);
+        ctx->cb(false, {}, "GetManagedObjects failed: " + msg);
+        return;
+    }
+
+    provision::bluez::AdapterPaths result{};
+    result.adapter_path = select_adapter(reply);
+    g_variant_unref(reply);
+
+    if (result.adapter_path.empty()) {
+        ctx->cb(false, {}, "No adapter found exposing GattManager1 and LEAdvertisingManager1");
+        return;
+    }
+
+    provision::log::info("BlueZ adapter selected: " + result.adapter_path);
+    ctx->cb(true, result, {});
+}
+
 void on_async_call_finished(GObject* source_object,
                             GAsyncResult* res,
                             gpointer user_data)
@@ -94,6 +166,7 @@ AdapterPaths find_adapter(GDBusConnection* system_bus)
 
     GError* err = nullptr;
 
+    PROVISION_BLOCKING_CALL_KNOWN("g_dbus_connection_call_sync GetManagedObjects");
     GVariant* reply = g_dbus_connection_call_sync(
         system_bus,
         BLUEZ_BUS,
@@ -110,27 +183,8 @@ AdapterPaths find_adapter(GDBusConnection* system_bus)
 
     if (!reply) throw make_error("GetManagedObjects failed: ", err);
 
-    GVariant* objects = nullptr;
-    g_variant_get(reply, "(@a{oa{sa{sv}}})", &objects);
-
     AdapterPaths result{};
-    GVariantIter outer;
-    const char* obj_path = nullptr;
-    GVariant* iface_dict = nullptr;
-
-    g_variant_iter_init(&outer, objects);
-    while (g_variant_iter_next(&outer, "{&o@a{sa{sv}}}", &obj_path, &iface_dict)) {
-        bool has_gatt = has_interface(iface_dict, GATT_MGR_IFACE);
-        bool has_adv  = has_interface(iface_dict, ADV_MGR_IFACE);
-        g_variant_unref(iface_dict);
-
-        if (has_gatt && has_adv) {
-            result.adapter_path = obj_path;
-            break;
-        }
-    }
-
-    g_variant_unref(objects);
+    result.adapter_path = select_adapter(reply);
     g_variant_unref(reply);
 
     if (result.adapter_path.empty()) {
@@ -141,6 +195,26 @@ AdapterPaths find_adapter(GDBusConnection* system_bus)
     return result;
 }
 
+void find_adapter_async(GDBusConnection* system_bus, AdapterCallback cb)
+{
+    auto* ctx = new FindAdapterCtx{std::move(cb)};
+
+    g_dbus_connection_call(
+        system_bus,
+        BLUEZ_BUS,
+        "/",
+        OM_IFACE,
+        "GetManagedObjects",
+        nullptr,
+        G_VARIANT_TYPE("(a{oa{sa{sv}}})"),
+        G_DBUS_CALL_FLAGS_NONE,
+        -1,
+        nullptr,
+        on_managed_objects,
+        ctx
+    );
+}
+
 /* ---------- Sync ---------- */
 
 void register_gatt_application(GDBusConnection* system_bus,
@@ -157,6 +231,7 @@ void register_gatt_application(GDBusConnection* system_bus,
     );
 
     GError* err = nullptr;
+    PROVISION_BLOCKING_CALL_KNOWN("g_dbus_connection_call_sync RegisterApplication");
     GVariant* reply = g_dbus_connection_call_sync(
         system_bus,
         BLUEZ_BUS,
@@ -189,6 +264,7 @@ void register_advertisement(GDBusConnection* system_bus,
     );
 
     GError* err = nullptr;
+    PROVISION_BLOCKING_CALL_KNOWN("g_dbus_connection_call_sync RegisterAdvertisement");
     GVariant* reply = g_dbus_connection_call_sync(
         system_bus,
         BLUEZ_BUS,
@@ -273,4 +349,50 @@ void register_advertisement_async(GDBusConnection* system_bus,
     );
 }
 
+void unregister_advertisement_async(GDBusConnection* system_bus,
+                                    const std::string& adapter_path,
+                                    const std::string& adv_path,
+                                    RegisterCallback cb)
+{
+    auto* ctx = new AsyncCtx{std::move(cb)};
+
+    g_dbus_connection_call(
+        system_bus,
+        BLUEZ_BUS,
+        adapter_path.c_str(),
+        ADV_MGR_IFACE,
+        "UnregisterAdvertisement",
+        g_variant_new("(o)", adv_path.c_str()),
+        nullptr,
+        G_DBUS_CALL_FLAGS_NONE,
+        -1,
+        nullptr,
+        on_async_call_finished,
+        ctx
+    );
+}
+
+void unregister_gatt_application_async(GDBusConnection* system_bus,
+                                       const std::string& adapter_path,
+                                       const std::string& app_path,
+                                       RegisterCallback cb)
+{
+    auto* ctx = new AsyncCtx{std::move(cb)};
+
+    g_dbus_connection_call(
+        system_bus,
+        BLUEZ_BUS,
+        adapter_path.c_str(),
+        GATT_MGR_IFACE,
+        "UnregisterApplication",
+        g_variant_new("(o)", app_path.c_str()),
+        nullptr,
+        G_DBUS_CALL_FLAGS_NONE,
+        -1,
+        nullptr,
+        on_async_call_finished,
+        ctx
+    );
+}
+
 } // namespace provision::bluez
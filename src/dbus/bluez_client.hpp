@@ -43,6 +43,15 @@ struct AdapterPaths {
  */
 AdapterPaths find_adapter(GDBusConnection* system_bus);
 
+/**
+ * Asynchronous find_adapter. cb receives (true, paths, "") or
+ * (false, {}, error).
+ */
+using AdapterCallback =
+    std::function<void(bool success, const AdapterPaths& paths, const std::string& error)>;
+
+void find_adapter_async(GDBusConnection* system_bus, AdapterCallback cb);
+
 /**
  * Synchronous registration (legacy / unused for Milestone 4)
  */
@@ -69,4 +78,17 @@ void register_advertisement_async(GDBusConnection* system_bus,
                                   const std::string& adv_path,
                                   RegisterCallback cb);
 
+/**
+ * Asynchronous teardown (counterparts of the calls above).
+ */
+void unregister_advertisement_async(GDBusConnection* system_bus,
+                                    const std::string& adapter_path,
+                                    const std::string& adv_path,
+                                    RegisterCallback cb);
+
+void unregister_gatt_application_async(GDBusConnection* system_bus,
+                                       const std::string& adapter_path,
+                                       const std::string& app_path,
+                                       RegisterCallback cb);
+
 } // namespace provision::bluez
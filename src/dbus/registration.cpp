@@ -0,0 +1,341 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   Implementation of the BlueZ registration lifecycle.
+ *
+ * Notes:
+ *   - Each appearance of org.bluez bumps a generation counter; callbacks
+ *     from an earlier bluetoothd instance compare it and bail out
+ *   - If no suitable adapter exists yet (hci not attached), the lookup is
+ *     retried every ADAPTER_RETRY_S seconds
+ *   - A failed power-up or registration step is retried with backoff
+ *     (RETRY_MIN_S doubling to RETRY_MAX_S)
+ *   - GATT application and advertisement are tracked separately, so a
+ *     failed RegisterAdvertisement never leaves an application behind
+ *     that we believe is gone
+ *   - Arm/disarm requests only record the wanted state; sync_registration()
+ *     walks towards it one async step at a time
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+
+#include "dbus/registration.hpp"
+#include "dbus/adapter_power.hpp"
+#include "dbus/agent.hpp"
+#include "dbus/bluez_client.hpp"
+#include "adv/advertisement.hpp"
+#include "gatt/service.hpp"
+#include "util/log.hpp"
+
+#include <algorithm>
+
+namespace {
+
+constexpr const char* BLUEZ_BUS = "org.bluez";
+constexpr guint ADAPTER_RETRY_S = 2;
+
+// Failed power-up or registration: retry after RETRY_MIN_S, doubling up
+// to RETRY_MAX_S. Reset on success and on every bluetoothd appearance.
+constexpr guint RETRY_MIN_S = 2;
+constexpr guint RETRY_MAX_S = 60;
+
+static GDBusConnection* g_bus = nullptr;   // not owned
+static std::string g_alias;
+static guint g_generation = 0;
+static guint g_retry_source = 0;
+static guint g_backoff_s = RETRY_MIN_S;
+static std::string g_adapter_path;        // empty until powered
+static bool g_want_armed = true;
+static bool g_app_registered = false;     // RegisterApplication done
+static bool g_adv_registered = false;     // RegisterAdvertisement done
+static bool g_busy = false;               // (un)registration in flight
+
+void locate_adapter(guint generation);
+void sync_registration();
+
+/**
+ * Retry whatever is missing: the adapter (lookup + power-up) if it is
+ * not ready yet, otherwise the registration step that failed.
+ */
+gboolean on_retry(gpointer)
+{
+    g_retry_source = 0;
+    if (g_adapter_path.empty())
+        locate_adapter(g_generation);
+    else
+        sync_registration();
+    return G_SOURCE_REMOVE;
+}
+
+void schedule_retry(guint delay_s)
+{
+    if (g_retry_source == 0)
+        g_retry_source = g_timeout_add_seconds(delay_s, on_retry, nullptr);
+}
+
+void schedule_backoff_retry(const std::string& what)
+{
+    provision::log::warn("registration: " + what + ", retrying in " +
+                         std::to_string(g_backoff_s) + "s");
+    schedule_retry(g_backoff_s);
+    g_backoff_s = std::min(g_backoff_s * 2, RETRY_MAX_S);
+}
+
+void cancel_retry()
+{
+    if (g_retry_source) {
+        g_source_remove(g_retry_source);
+        g_retry_source = 0;
+    }
+}
+
+void register_application(guint generation)
+{
+    g_busy = true;
+
+    provision::bluez::register_gatt_application_async(
+        g_bus,
+        g_adapter_path,
+        provision::gatt::APP_PATH,
+        [generation](bool ok, const std::string& err) {
+            if (generation != g_generation)
+                return;
+
+            g_busy = false;
+
+            if (!ok) {
+                provision::log::error("RegisterApplication failed: " + err);
+                schedule_backoff_retry("RegisterApplication failed");
+                return;
+            }
+
+            g_app_registered = true;
+            provision::log::info("GATT application registered");
+            sync_registration();
+        }
+    );
+}
+
+void register_advertisement(guint generation)
+{
+    g_busy = true;
+
+    provision::bluez::register_advertisement_async(
+        g_bus,
+        g_adapter_path,
+        provision::adv::ADV_PATH,
+        [generation](bool ok, const std::string& err) {
+            if (generation != g_generation)
+                return;
+
+            g_busy = false;
+
+            // The application stays registered; only this step is retried.
+            if (!ok) {
+                provision::log::error("RegisterAdvertisement failed: " + err);
+                schedule_backoff_retry("RegisterAdvertisement failed");
+                return;
+            }
+
+            g_adv_registered = true;
+            g_backoff_s = RETRY_MIN_S;
+            provision::log::info("Advertisement registered");
+            sync_registration();
+        }
+    );
+}
+
+void unregister_advertisement(guint generation)
+{
+    g_busy = true;
+
+    provision::bluez::unregister_advertisement_async(
+        g_bus,
+        g_adapter_path,
+        provision::adv::ADV_PATH,
+        [generation](bool ok, const std::string& err) {
+            if (generation != g_generation)
+                return;
+
+            // Failing here means bluetoothd no longer holds it either.
+            if (!ok)
+                provision::log::warn("UnregisterAdvertisement failed: " + err);
+
+            g_busy = false;
+            g_adv_registered = false;
+            provision::log::info("Advertisement withdrawn");
+            sync_registration();
+        }
+    );
+}
+
+void unregister_application(guint generation)
+{
+    g_busy = true;
+
+    provision::bluez::unregister_gatt_application_async(
+        g_bus,
+        g_adapter_path,
+        provision::gatt::APP_PATH,
+        [generation](bool ok, const std::string& err) {
+            if (generation != g_generation)
+                return;
+
+            if (!ok)
+                provision::log::warn("UnregisterApplication failed: " + err);
+
+            g_busy = false;
+            g_app_registered = false;
+            provision::log::info("GATT application withdrawn");
+            sync_registration();
+        }
+    );
+}
+
+/**
+ * Drive the BlueZ registration towards g_want_armed, one step at a time:
+ * application before advertisement when arming, the reverse when
+ * disarming. Re-run after every completed step, so a request made while
+ * one was in flight is not lost.
+ */
+void sync_registration()
+{
+    if (g_busy || g_adapter_path.empty())
+        return;
+
+    if (g_want_armed) {
+        if (!g_app_registered)
+            register_application(g_generation);
+        else if (!g_adv_registered)
+            register_advertisement(g_generation);
+    } else {
+        if (g_adv_registered)
+            unregister_advertisement(g_generation);
+        else if (g_app_registered)
+            unregister_application(g_generation);
+    }
+}
+
+void locate_adapter(guint generation)
+{
+    provision::bluez::find_adapter_async(
+        g_bus,
+        [generation](bool ok, const provision::bluez::AdapterPaths& paths,
+                     const std::string& err) {
+            if (generation != g_generation)
+                return;
+
+            if (!ok) {
+                provision::log::warn("registration: " + err + ", retrying");
+                schedule_retry(ADAPTER_RETRY_S);
+                return;
+            }
+
+            const std::string adapter_path = paths.adapter_path;
+            provision::bluez::ensure_adapter_ready_async(
+                g_bus,
+                adapter_path,
+                [generation, adapter_path](bool ready, const std::string& power_err) {
+                    if (generation != g_generation)
+                        return;
+
+                    // A slow controller must not leave us unregistered
+                    // for good: power it up again later.
+                    if (!ready) {
+                        schedule_backoff_retry("adapter not ready (" + power_err + ")");
+                        return;
+                    }
+
+                    g_adapter_path = adapter_path;
+                    g_backoff_s = RETRY_MIN_S;
+                    provision::adv::set_ble_alias(g_bus, adapter_path, g_alias);
+                    provision::bluez::register_agent();
+                    sync_registration();
+                }
+            );
+        }
+    );
+}
+
+/**
+ * Forget everything registered with the previous bluetoothd instance.
+ */
+void reset_state()
+{
+    ++g_generation;
+    cancel_retry();
+    g_backoff_s = RETRY_MIN_S;
+    g_app_registered = false;
+    g_adv_registered = false;
+    g_busy = false;
+    g_adapter_path.clear();
+}
+
+void on_bluez_appeared(GDBusConnection*, const gchar*, const gchar* owner, gpointer)
+{
+    reset_state();
+
+    provision::log::info(std::string("bluetoothd appeared (") + owner + "), registering");
+    locate_adapter(g_generation);
+}
+
+void on_bluez_vanished(GDBusConnection*, const gchar*, gpointer)
+{
+    if (g_adv_registered)
+        provision::log::warn("bluetoothd vanished, waiting for it to return");
+
+    reset_state();
+}
+
+} // namespace
+
+namespace provision::bluez {
+
+void start_registration(GDBusConnection* system_bus, const std::string& alias)
+{
+    g_bus = system_bus;
+    g_alias = alias;
+
+    g_bus_watch_name_on_connection(
+        system_bus,
+        BLUEZ_BUS,
+        G_BUS_NAME_WATCHER_FLAGS_NONE,
+        on_bluez_appeared,
+        on_bluez_vanished,
+        nullptr,
+        nullptr
+    );
+}
+
+void set_armed(bool armed)
+{
+    if (armed == g_want_armed)
+        return;
+
+    g_want_armed = armed;
+    provision::log::info(std::string("registration: ") +
+                         (armed ? "arming" : "disarming") + " provisioning");
+    sync_registration();
+}
+
+bool is_armed()
+{
+    return g_want_armed;
+}
+
+bool is_registered()
+{
+    return g_adv_registered;
+}
+
+} // namespace provision::bluez
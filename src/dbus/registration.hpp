@@ -0,0 +1,57 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   BlueZ registration lifecycle (adapter, agent, GATT app, advertisement).
+ *
+ * Notes:
+ *   - Watches the org.bluez bus name; every time bluetoothd appears the
+ *     adapter is located, powered (see adapter_power.hpp) and only then
+ *     are the agent, GATT application and advertisement registered
+ *   - A bluetoothd restart therefore re-registers without restarting us
+ *   - Objects must already be exported before start_registration()
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+#include <string>
+
+namespace provision::bluez {
+
+/**
+ * Start watching bluetoothd and register whenever it is (re)started.
+ * alias is written to Adapter1.Alias before advertising.
+ */
+void start_registration(GDBusConnection* system_bus, const std::string& alias);
+
+/**
+ * Arm (register GATT app + advertisement) or disarm (unregister both).
+ * Starts armed. Remembered across bluetoothd restarts; the adapter,
+ * alias and agent stay set up either way.
+ */
+void set_armed(bool armed);
+
+/**
+ * True while provisioning is wanted (set_armed), whether or not it is
+ * registered yet.
+ */
+bool is_armed();
+
+/**
+ * True once the advertisement is registered with the current bluetoothd.
+ */
+bool is_registered();
+
+} // namespace provision::bluez
@@ -18,10 +18,15 @@
 
 #include "gatt/characteristic.hpp"
 #include "util/log.hpp"
+#include "util/mem_governor.hpp"
+#include "util/metrics.hpp"
+#include "util/trace.hpp"
 
+#include <deque>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace {
 
@@ -30,7 +35,7 @@ struct CharContext {
     std::string uuid;
     std::string object_path;
     std::string service_path;
-    const char* const* flags;
+    std::vector<std::string> flags; // effective (after link security)
 
     // Callbacks
     provision::gatt::ReadCallback read_cb;
@@ -43,11 +48,42 @@ struct CharContext {
 
     // Cached Value property ("ay") used for notifications
     GVariant* value_ay{nullptr};
+
+    // Fast path: PropertiesChanged header built once, copied per emit
+    GDBusMessage* notify_template{nullptr};
 };
 
 // Track characteristics so State can emit notifications by object_path
 static std::unordered_map<std::string, CharContext*> g_chars;
 
+static provision::gatt::LinkSecurity g_link_security =
+    provision::gatt::LinkSecurity::NONE;
+
+static bool g_notify_fast_path = true;
+
+/**
+ * Map requested flags to the ones reported to BlueZ under g_link_security.
+ */
+std::vector<std::string> effective_flags(const char* const* flags)
+{
+    using provision::gatt::LinkSecurity;
+
+    const char* prefix = nullptr;
+    if (g_link_security == LinkSecurity::ENCRYPT)
+        prefix = "encrypt-";
+    else if (g_link_security == LinkSecurity::AUTHENTICATED)
+        prefix = "encrypt-authenticated-";
+
+    std::vector<std::string> out;
+    for (int i = 0; flags && flags[i]; ++i) {
+        std::string f = flags[i];
+        if (prefix && (f == "read" || f == "write" || f == "notify"))
+            f = prefix + f;
+        out.push_back(f);
+    }
+    return out;
+}
+
 /**
  * Introspection XML for org.bluez.GattCharacteristic1.
  *
@@ -119,8 +155,8 @@ GVariant* on_get_property(GDBusConnection*,
     if (std::string(prop) == "Flags") {
         GVariantBuilder b;
         g_variant_builder_init(&b, G_VARIANT_TYPE("as"));
-        for (int i = 0; ctx->flags && ctx->flags[i]; ++i)
-            g_variant_builder_add(&b, "s", ctx->flags[i]);
+        for (const auto& f : ctx->flags)
+            g_variant_builder_add(&b, "s", f.c_str());
         return g_variant_builder_end(&b);
     }
 
@@ -236,6 +272,355 @@ if (!g_variant_is_of_type(invalidated_v, G_VARIANT_TYPE("as"))) {
 }
 
 
+// -----------------------------------------------------------------------------
+// Notify fast path
+// -----------------------------------------------------------------------------
+//
+// emit_value_changed() parses type strings, runs two builders and re-checks
+// the result on every call. Here the signal header is built once per
+// characteristic and the body is assembled from cached children, so only
+// the Value itself is new per notification.
+//
+
+/**
+ * Body "(sa{sv}as)" of a Value PropertiesChanged, without type-string
+ * parsing: interface name, key and empty invalidated list are shared.
+ */
+GVariant* value_changed_body(GVariant* value_ay)
+{
+    static GVariant* iface = nullptr;
+    static GVariant* key = nullptr;
+    static GVariant* invalidated = nullptr;
+
+    if (!iface) {
+        iface = g_variant_ref_sink(g_variant_new_string("org.bluez.GattCharacteristic1"));
+        key = g_variant_ref_sink(g_variant_new_string("Value"));
+        invalidated = g_variant_ref_sink(
+            g_variant_new_array(G_VARIANT_TYPE_STRING, nullptr, 0));
+    }
+
+    GVariant* entry = g_variant_new_dict_entry(key, g_variant_new_variant(value_ay));
+    GVariant* children[] = {
+        iface,
+        g_variant_new_array(nullptr, &entry, 1),
+        invalidated
+    };
+    return g_variant_new_tuple(children, 3);
+}
+
+/**
+ * Queue ctx->value_ay as a PropertiesChanged signal on the connection.
+ * Does not flush; see flush_notifications().
+ */
+void emit_value_changed_fast(CharContext* ctx)
+{
+    if (!ctx->notify_template) {
+        ctx->notify_template = g_dbus_message_new_signal(
+            ctx->object_path.c_str(),
+            "org.freedesktop.DBus.Properties",
+            "PropertiesChanged");
+    }
+
+    GDBusMessage* msg = g_dbus_message_copy(ctx->notify_template, nullptr);
+    g_dbus_message_set_body(msg, value_changed_body(ctx->value_ay));
+
+    GError* err = nullptr;
+    if (!g_dbus_connection_send_message(ctx->system_bus, msg,
+                                        G_DBUS_SEND_MESSAGE_FLAGS_NONE,
+                                        nullptr, &err)) {
+        provision::log::error(std::string("notify: send failed for ") +
+                              ctx->object_path + ": " +
+                              (err && err->message ? err->message : "unknown error"));
+        if (err) g_error_free(err);
+    }
+
+    g_object_unref(msg);
+}
+
+/**
+ * One flush per pump tick instead of per fragment.
+ */
+void flush_notifications(GDBusConnection* bus)
+{
+    g_dbus_connection_flush(bus, nullptr, nullptr, nullptr);
+}
+
+// -----------------------------------------------------------------------------
+// Notify priority lanes
+// -----------------------------------------------------------------------------
+//
+// BlueZ forwards every PropertiesChanged as one ATT notification, and the
+// link drains those far slower than we can emit them. Anything emitted while
+// the pump is active is queued on its lane; each tick the pump sends up to
+// NOTIFY_FRAGMENTS_PER_TICK fragments, picking the highest non-starved lane
+// again for every one of them, and flushes once at the end of the tick.
+//
+
+constexpr size_t LANE_COUNT = 3;
+
+// Minimum spacing between ticks once a backlog exists.
+constexpr guint NOTIFY_PUMP_INTERVAL_MS = 10;
+
+// A non-empty lane passed over for this many fragments in a row is served next.
+constexpr unsigned NOTIFY_STARVATION_LIMIT = 8;
+
+struct PendingNotify {
+    CharContext* ctx;
+    GVariant* value_ay; // owned ref
+};
+
+static std::deque<PendingNotify> g_lanes[LANE_COUNT];
+static unsigned g_lane_skipped[LANE_COUNT] = {};
+static guint g_pump_source = 0;
+static size_t g_queued_bytes = 0;
+
+size_t queued_cost(const PendingNotify& pending)
+{
+    return sizeof(PendingNotify) + g_variant_get_size(pending.value_ay);
+}
+
+/**
+ * Report the backlog to the memory governor. Accounted only: queued
+ * values are still owed to the client, so they are never evicted.
+ */
+void account_queue()
+{
+    static const provision::mem::ConsumerId id = provision::mem::register_consumer(
+        "notify queue", provision::mem::Tier::NOTIFY_QUEUE, nullptr);
+    provision::mem::set_usage(id, g_queued_bytes);
+}
+
+size_t lane_index(provision::gatt::NotifyPriority priority)
+{
+    return static_cast<size_t>(priority);
+}
+
+bool lanes_empty()
+{
+    for (const auto& lane : g_lanes) {
+        if (!lane.empty())
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Pick the lane for the next fragment, or LANE_COUNT if all are empty.
+ */
+size_t pick_lane()
+{
+    size_t chosen = LANE_COUNT;
+
+    // Starved lanes win, lowest priority first (it has waited longest).
+    for (size_t i = LANE_COUNT; i-- > 0;) {
+        if (!g_lanes[i].empty() && g_lane_skipped[i] >= NOTIFY_STARVATION_LIMIT) {
+            chosen = i;
+            break;
+        }
+    }
+
+    if (chosen == LANE_COUNT) {
+        for (size_t i = 0; i < LANE_COUNT; ++i) {
+            if (!g_lanes[i].empty()) {
+                chosen = i;
+                break;
+            }
+        }
+    }
+
+    if (chosen == LANE_COUNT)
+        return chosen;
+
+    for (size_t i = 0; i < LANE_COUNT; ++i) {
+        if (i == chosen)
+            g_lane_skipped[i] = 0;
+        else if (i > chosen && !g_lanes[i].empty())
+            ++g_lane_skipped[i];
+    }
+
+    return chosen;
+}
+
+/**
+ * Swap the pending value into the characteristic cache and emit it.
+ * Takes ownership of pending.value_ay. Returns false if it was dropped.
+ */
+bool emit_pending(const PendingNotify& pending)
+{
+    CharContext* ctx = pending.ctx;
+
+    // Client may have called StopNotify while this was queued.
+    if (!ctx->notifying) {
+        g_variant_unref(pending.value_ay);
+        provision::metrics::inc(provision::metrics::Counter::NOTIFY_DROPPED);
+        return false;
+    }
+
+    if (ctx->value_ay)
+        g_variant_unref(ctx->value_ay);
+    ctx->value_ay = pending.value_ay;
+
+    PROVISION_TRACE3(notify_emit, ctx->object_path.c_str(),
+                     g_variant_get_size(ctx->value_ay),
+                     static_cast<int>(g_notify_fast_path));
+
+    if (g_notify_fast_path)
+        emit_value_changed_fast(ctx);
+    else
+        emit_value_changed(ctx);
+
+    provision::metrics::inc(provision::metrics::Counter::NOTIFY_EMITTED);
+    return true;
+}
+
+/**
+ * One pump tick: up to NOTIFY_FRAGMENTS_PER_TICK fragments, the lane
+ * chosen afresh for each, so a higher lane preempts at the next fragment
+ * boundary and starvation accounting stays per fragment. The fast path
+ * flushes once at the end. Returns false if every lane was empty.
+ */
+bool pump_tick()
+{
+    // All characteristics live on the one system bus connection.
+    GDBusConnection* bus = nullptr;
+    size_t picked = 0;
+
+    while (picked < provision::gatt::NOTIFY_FRAGMENTS_PER_TICK) {
+        const size_t lane = pick_lane();
+        if (lane == LANE_COUNT)
+            break;
+
+        PendingNotify next = g_lanes[lane].front();
+        g_lanes[lane].pop_front();
+        g_queued_bytes -= queued_cost(next);
+        ++picked;
+
+        if (emit_pending(next))
+            bus = next.ctx->system_bus;
+    }
+
+    if (picked == 0)
+        return false;
+
+    if (g_notify_fast_path && bus)
+        flush_notifications(bus);
+
+    account_queue();
+    return true;
+}
+
+gboolean on_notify_pump(gpointer)
+{
+    if (!pump_tick()) {
+        // Backlog drained and one interval has passed: next notify goes out
+        // immediately again.
+        g_pump_source = 0;
+        return G_SOURCE_REMOVE;
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
+void start_pump()
+{
+    if (g_pump_source == 0)
+        g_pump_source = g_timeout_add(NOTIFY_PUMP_INTERVAL_MS, on_notify_pump, nullptr);
+}
+
+void enqueue_notify(CharContext* ctx,
+                    GVariant* const* values,
+                    size_t count,
+                    provision::gatt::NotifyPriority priority)
+{
+    auto& lane = g_lanes[lane_index(priority)];
+    const bool idle = g_pump_source == 0 && lanes_empty();
+
+    for (size_t i = 0; i < count; ++i) {
+        lane.push_back({ctx, g_variant_ref_sink(values[i])});
+        g_queued_bytes += queued_cost(lane.back());
+    }
+    account_queue();
+
+    // Nothing pending and outside a pump interval: the first tick's worth
+    // goes out right away, the rest follows on the pump.
+    if (idle)
+        pump_tick();
+
+    start_pump();
+}
+
+/**
+ * Drop everything queued for a characteristic (on StopNotify).
+ */
+void drop_pending(CharContext* ctx)
+{
+    for (auto& lane : g_lanes) {
+        for (auto it = lane.begin(); it != lane.end();) {
+            if (it->ctx == ctx) {
+                g_queued_bytes -= queued_cost(*it);
+                g_variant_unref(it->value_ay);
+                it = lane.erase(it);
+                provision::metrics::inc(provision::metrics::Counter::NOTIFY_DROPPED);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    account_queue();
+}
+
+/**
+ * "offset" from ReadValue options (a{sv}), 0 if absent.
+ */
+guint16 read_offset(GVariant* parameters)
+{
+    GVariant* options = nullptr;
+    g_variant_get(parameters, "(@a{sv})", &options);
+
+    guint16 offset = 0;
+    if (options) {
+        g_variant_lookup(options, "offset", "q", &offset);
+        g_variant_unref(options);
+    }
+    return offset;
+}
+
+/**
+ * Return value_ay from offset on as a ReadValue reply. BlueZ issues
+ * offset reads (ATT Read Blob) when the value exceeds the MTU.
+ * Floating refs are sunk; otherwise the caller keeps its own.
+ */
+void return_read_value(GDBusMethodInvocation* invocation,
+                       GVariant* value_ay,
+                       guint16 offset)
+{
+    g_variant_ref_sink(value_ay);
+
+    gsize len = 0;
+    const auto* data = static_cast<const guint8*>(
+        g_variant_get_fixed_array(value_ay, &len, 1));
+
+    if (offset > len) {
+        g_variant_unref(value_ay);
+        g_dbus_method_invocation_return_dbus_error(
+            invocation,
+            "org.bluez.Error.InvalidOffset",
+            "Offset past end of value"
+        );
+        return;
+    }
+
+    GVariant* slice = offset == 0
+        ? g_variant_ref(value_ay)
+        : g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE, data + offset, len - offset, 1);
+
+    g_dbus_method_invocation_return_value(invocation, g_variant_new_tuple(&slice, 1));
+
+    if (offset == 0)
+        g_variant_unref(slice);
+    g_variant_unref(value_ay);
+}
 
 std::runtime_error make_error(const std::string& prefix, GError* err)
 {
@@ -246,18 +631,21 @@ std::runtime_error make_error(const std::string& prefix, GError* err)
 }
 
 // Method handler
-void on_method_call(GDBusConnection*,
-                    const gchar*,
-                    const gchar*,
-                    const gchar*,
-                    const gchar* method,
-                    GVariant* parameters,
-                    GDBusMethodInvocation* invocation,
-                    gpointer user_data)
+void handle_method_call(CharContext* ctx,
+                        const gchar* method,
+                        GVariant* parameters,
+                        GDBusMethodInvocation* invocation)
 {
-    auto* ctx = static_cast<CharContext*>(user_data);
 
     if (std::string(method) == "ReadValue") {
+        const guint16 offset = read_offset(parameters);
+
+        // Without a callback, serve the cache (set_characteristic_value).
+        if (!ctx->read_cb && ctx->value_ay) {
+            return_read_value(invocation, ctx->value_ay, offset);
+            return;
+        }
+
         if (!ctx->read_cb) {
             g_dbus_method_invocation_return_dbus_error(
                 invocation,
@@ -267,12 +655,8 @@ void on_method_call(GDBusConnection*,
             return;
         }
 
-        // ReadValue remains callback-driven (no behavior change).
-        GVariant* value = ctx->read_cb();
-        g_dbus_method_invocation_return_value(
-            invocation,
-            g_variant_new_tuple(&value, 1)
-        );
+        // ReadValue remains callback-driven; the offset is applied here.
+        return_read_value(invocation, ctx->read_cb(), offset);
         return;
     }
 
@@ -317,7 +701,8 @@ void on_method_call(GDBusConnection*,
 
     if (std::string(method) == "StopNotify") {
         ctx->notifying = false;
-        
+        drop_pending(ctx);
+
         if (ctx->notify_cb)
             ctx->notify_cb(false);
         g_dbus_method_invocation_return_value(invocation, nullptr);
@@ -331,6 +716,28 @@ void on_method_call(GDBusConnection*,
     );
 }
 
+void on_method_call(GDBusConnection*,
+                    const gchar*,
+                    const gchar*,
+                    const gchar*,
+                    const gchar* method,
+                    GVariant* parameters,
+                    GDBusMethodInvocation* invocation,
+                    gpointer user_data)
+{
+    auto* ctx = static_cast<CharContext*>(user_data);
+
+    PROVISION_TRACE2(char_method_entry, ctx->object_path.c_str(), method);
+    const gint64 start_us =
+        PROVISION_TRACE_ENABLED(char_method_exit) ? g_get_monotonic_time() : 0;
+
+    handle_method_call(ctx, method, parameters, invocation);
+
+    if (start_us)
+        PROVISION_TRACE3(char_method_exit, ctx->object_path.c_str(), method,
+                         g_get_monotonic_time() - start_us);
+}
+
 const GDBusInterfaceVTable CHAR_VTABLE = {
     on_method_call,
     on_get_property,
@@ -357,7 +764,7 @@ void export_characteristic(GDBusConnection* system_bus,
         uuid,
         object_path,
         service_path,
-        flags,
+        effective_flags(flags),
         read_cb,
         notify_cb,
         write_cb,
@@ -396,7 +803,63 @@ void export_characteristic(GDBusConnection* system_bus,
     
 }
 
-void notify_characteristic_value(const std::string& object_path, GVariant* value_ay)
+void set_link_security(LinkSecurity security)
+{
+    g_link_security = security;
+}
+
+void set_notify_fast_path(bool enabled)
+{
+    g_notify_fast_path = enabled;
+}
+
+void set_characteristic_notifying(const std::string& object_path, bool enabled)
+{
+    auto it = g_chars.find(object_path);
+    if (it == g_chars.end())
+        return;
+
+    it->second->notifying = enabled;
+    if (!enabled)
+        drop_pending(it->second);
+}
+
+std::vector<std::string> characteristic_flags(const std::string& object_path)
+{
+    auto it = g_chars.find(object_path);
+    if (it == g_chars.end())
+        return {};
+    return it->second->flags;
+}
+
+void set_characteristic_value(const std::string& object_path, GVariant* value_ay)
+{
+    auto it = g_chars.find(object_path);
+    if (it == g_chars.end() || !value_ay)
+        return;
+
+    CharContext* ctx = it->second;
+    g_variant_ref_sink(value_ay);
+    if (ctx->value_ay)
+        g_variant_unref(ctx->value_ay);
+    ctx->value_ay = value_ay;
+}
+
+void notify_characteristic_value(const std::string& object_path,
+                                 GVariant* value_ay,
+                                 NotifyPriority priority)
+{
+    if (!value_ay) {
+        provision::log::warn("notify: null value for " + object_path);
+        return;
+    }
+
+    notify_characteristic_burst(object_path, {value_ay}, priority);
+}
+
+void notify_characteristic_burst(const std::string& object_path,
+                                 const std::vector<GVariant*>& fragments,
+                                 NotifyPriority priority)
 {
     auto it = g_chars.find(object_path);
     if (it == g_chars.end()) {
@@ -410,19 +873,17 @@ void notify_characteristic_value(const std::string& object_path, GVariant* value
         return;
     }
 
-    if (!value_ay) {
-        provision::log::warn("notify: null value for " + object_path);
-        return;
+    for (GVariant* v : fragments) {
+        if (!v) {
+            provision::log::warn("notify: null fragment for " + object_path);
+            return;
+        }
     }
 
-    if (ctx->value_ay)
-        g_variant_unref(ctx->value_ay);
-
-    // Sink the variant so lifetime is stable after caller returns
-    ctx->value_ay = g_variant_ref_sink(value_ay);
+    if (fragments.empty())
+        return;
 
-    provision::log::info("notify: emitting Value change for " + object_path);
-    emit_value_changed(ctx);
+    enqueue_notify(ctx, fragments.data(), fragments.size(), priority);
 }
 
 } // namespace provision::gatt
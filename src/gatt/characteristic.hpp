@@ -22,7 +22,9 @@
 #pragma once
 
 #include <gio/gio.h>
+#include <cstddef>
 #include <string>
+#include <vector>
 
 namespace provision::gatt {
 
@@ -49,6 +51,62 @@ using NotifyStateCallback = void (*)(bool enabled);
  */
 using WriteCallback = void (*)(GVariant* value_ay);
 
+/**
+ * Notification priority lanes.
+ *
+ * Outbound notifications are queued per lane. Each pump tick sends up to
+ * NOTIFY_FRAGMENTS_PER_TICK fragments and picks the lane again for every
+ * fragment, highest lane first. A higher lane therefore preempts a lower
+ * one at the next fragment boundary, while a starvation limit still
+ * guarantees lower lanes (bulk streams) make progress. The fragments of
+ * one tick share a single flush.
+ */
+enum class NotifyPriority {
+    CONTROL,     // provisioning state transitions (CONNECTED, FAILED, ...)
+    INTERACTIVE, // results of a client request (scan lists)
+    BULK         // large streams (logs, telemetry)
+};
+
+/**
+ * Fragments sent per notify pump tick (and synchronously when the pump
+ * is idle).
+ */
+inline constexpr std::size_t NOTIFY_FRAGMENTS_PER_TICK = 4;
+
+/**
+ * Link security required by exported characteristics.
+ *
+ * Applied at export time: read/write/notify flags are replaced by their
+ * encrypt-* (or encrypt-authenticated-*) variants so BlueZ requires an
+ * encrypted (or MITM-protected) link before the first access.
+ */
+enum class LinkSecurity {
+    NONE,
+    ENCRYPT,
+    AUTHENTICATED
+};
+
+/**
+ * Set link security for characteristics exported after this call.
+ */
+void set_link_security(LinkSecurity security);
+
+/**
+ * Select how notifications are put on the bus.
+ *
+ * true (default): per-characteristic prebuilt PropertiesChanged header,
+ * body assembled from cached parts, one flush per pump tick.
+ * false: the original g_dbus_connection_emit_signal path, kept for
+ * comparison.
+ */
+void set_notify_fast_path(bool enabled);
+
+/**
+ * Set the notifying state directly, without StartNotify/StopNotify and
+ * without running notify_cb. For the --bench run, which has no client.
+ */
+void set_characteristic_notifying(const std::string& object_path, bool enabled);
+
 /**
  * Export a GATT characteristic object.
  *
@@ -71,6 +129,20 @@ void export_characteristic(GDBusConnection* system_bus,
                            NotifyStateCallback notify_cb = nullptr,
                            WriteCallback write_cb = nullptr);
 
+/**
+ * Effective flags of an exported characteristic (after link security),
+ * as reported to BlueZ. Empty if object_path is unknown.
+ */
+std::vector<std::string> characteristic_flags(const std::string& object_path);
+
+/**
+ * Replace the cached Value without notifying.
+ *
+ * A characteristic exported without read_cb serves ReadValue from this
+ * cache. Floating refs are sunk; otherwise the caller keeps its own.
+ */
+void set_characteristic_value(const std::string& object_path, GVariant* value_ay);
+
 /**
  * Emit a notification by updating the cached Value and emitting
  * org.freedesktop.DBus.Properties.PropertiesChanged for "Value".
@@ -78,7 +150,24 @@ void export_characteristic(GDBusConnection* system_bus,
  * - object_path must match the characteristic object path used at export.
  * - value_ay must be a GVariant of type "ay".
  * - If notifications are not enabled (StartNotify not called), this is a no-op.
+ * - The value is referenced (floating refs are sunk); the caller keeps its own.
+ * - If nothing is pending the value is emitted immediately, otherwise it is
+ *   queued on the given priority lane and emitted by the notify pump.
+ */
+void notify_characteristic_value(const std::string& object_path,
+                                 GVariant* value_ay,
+                                 NotifyPriority priority = NotifyPriority::CONTROL);
+
+/**
+ * Notify the fragments of one logical message.
+ *
+ * Same rules as notify_characteristic_value; the fragments are queued in
+ * order on one lane. They go out like any other queued fragments, so a
+ * higher lane may preempt between them; fragments sent in the same tick
+ * share one flush.
  */
-void notify_characteristic_value(const std::string& object_path, GVariant* value_ay);
+void notify_characteristic_burst(const std::string& object_path,
+                                 const std::vector<GVariant*>& fragments,
+                                 NotifyPriority priority = NotifyPriority::CONTROL);
 
 } // namespace provision::gatt
@@ -27,8 +27,11 @@
 #include "gatt/service.hpp"
 #include "gatt/state.hpp"
 #include "util/log.hpp"
+#include "util/metrics.hpp"
+#include "util/trace.hpp"
 
 #include <gio/gio.h>
+#include <cstdint>
 #include <string>
 
 namespace {
@@ -89,18 +92,44 @@ std::string json_get_string(const std::string& payload, const std::string& key)
 }
 
 /**
- * WriteValue callback for Command characteristic.
+ * Very small JSON unsigned integer extractor:
+ *   Finds: "<key>" : <digits>
+ *
+ * Returns fallback if the key is missing or not a number.
  */
-void on_write_command(GVariant* value)
+std::uint64_t json_get_uint(const std::string& payload,
+                            const std::string& key,
+                            std::uint64_t fallback)
 {
-    std::string payload = ay_to_string(value);
+    const std::string needle = "\"" + key + "\"";
+    size_t k = payload.find(needle);
+    if (k == std::string::npos)
+        return fallback;
 
-    if (payload.empty()) {
-        provision::log::warn("Command WriteValue: empty payload");
-        return;
+    size_t colon = payload.find(':', k + needle.size());
+    if (colon == std::string::npos)
+        return fallback;
+
+    size_t p = payload.find_first_not_of(" \t\r\n", colon + 1);
+    if (p == std::string::npos || payload[p] < '0' || payload[p] > '9')
+        return fallback;
+
+    std::uint64_t value = 0;
+    while (p < payload.size() && payload[p] >= '0' && payload[p] <= '9') {
+        value = value * 10 + static_cast<std::uint64_t>(payload[p] - '0');
+        ++p;
     }
+    return value;
+}
 
-    provision::log::info("Command WriteValue: " + payload);
+/**
+ * Command dispatcher shared by the BLE Command characteristic and the
+ * local control socket.
+ */
+void dispatch(const std::string& payload, provision::gatt::CommandSource source)
+{
+    // Every source passes through here exactly once.
+    provision::metrics::inc(provision::metrics::Counter::COMMANDS);
 
     // Primary op field
     std::string op = json_get_string(payload, "op");
@@ -114,6 +143,34 @@ void on_write_command(GVariant* value)
             op = "wifi_connect";
     }
 
+    PROVISION_TRACE3(command_dispatch, op.c_str(), payload.size(),
+                     static_cast<int>(source));
+
+    // ------------------------------------------------------------
+    // resume
+    // Expected payload:
+    // { "op":"resume", "token":"...", "last_seq":N }
+    // ------------------------------------------------------------
+    if (op == "resume") {
+        // Sessions belong to the BLE link; a local client must not rebind
+        // or detach the phone's session or trigger a replay to it.
+        if (source != provision::gatt::CommandSource::BLE) {
+            provision::log::warn("Command dispatch: resume rejected (not BLE)");
+            return;
+        }
+
+        std::string token = json_get_string(payload, "token");
+        std::uint64_t last_seq = json_get_uint(payload, "last_seq", 0);
+
+        provision::log::info("Command dispatch: resume");
+        provision::gatt::handle_session_resume(token, last_seq);
+        return;
+    }
+
+    // Any other command on an unbound BLE link starts a new session.
+    if (!op.empty() && source == provision::gatt::CommandSource::BLE)
+        provision::gatt::ensure_session();
+
     // ------------------------------------------------------------
     // wifi_scan
     // ------------------------------------------------------------
@@ -142,6 +199,16 @@ void on_write_command(GVariant* value)
         return;
     }
 
+    // ------------------------------------------------------------
+    // status
+    // Re-publishes the current state on the State event stream.
+    // ------------------------------------------------------------
+    if (op == "status") {
+        provision::log::info("Command dispatch: status");
+        provision::gatt::handle_status_request();
+        return;
+    }
+
     // ------------------------------------------------------------
     // Unknown
     // ------------------------------------------------------------
@@ -153,6 +220,22 @@ void on_write_command(GVariant* value)
     provision::log::warn("Command dispatch: no op/cmd field");
 }
 
+/**
+ * WriteValue callback for Command characteristic.
+ */
+void on_write_command(GVariant* value)
+{
+    std::string payload = ay_to_string(value);
+
+    if (payload.empty()) {
+        provision::log::warn("Command WriteValue: empty payload");
+        return;
+    }
+
+    provision::log::info("Command WriteValue: " + payload);
+    dispatch(payload, provision::gatt::CommandSource::BLE);
+}
+
 
 // Flags: write (with response)
 static const char* FLAGS[] = {
@@ -180,4 +263,14 @@ void export_command(GDBusConnection* system_bus)
     provision::log::info("Command characteristic exported");
 }
 
+void dispatch_command(const std::string& payload, CommandSource source)
+{
+    if (payload.empty()) {
+        provision::log::warn("Command dispatch: empty payload");
+        return;
+    }
+
+    dispatch(payload, source);
+}
+
 } // namespace provision::gatt
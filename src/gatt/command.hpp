@@ -25,9 +25,20 @@
 #pragma once
 
 #include <gio/gio.h>
+#include <string>
 
 namespace provision::gatt {
 
+/**
+ * Where a command came from.
+ *
+ * BLE commands bind the link to a resumable session; local ones do not.
+ */
+enum class CommandSource {
+    BLE,
+    LOCAL
+};
+
 /**
  * Export the Command characteristic (write-only).
  *
@@ -35,4 +46,12 @@ namespace provision::gatt {
  */
 void export_command(GDBusConnection* system_bus);
 
+/**
+ * Dispatch a JSON command payload (e.g. {"op":"wifi_scan"}).
+ *
+ * Results are published on the State event stream. Must be called on the
+ * GLib main context.
+ */
+void dispatch_command(const std::string& payload, CommandSource source);
+
 } // namespace provision::gatt
@@ -0,0 +1,293 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   Implementation of the extension characteristics.
+ *
+ * Notes:
+ *   - A poll is one acquire load of head per ring when nothing changed
+ *   - Each new entry is copied once, from the slot straight into the
+ *     GVariant that is both notified and cached; the copy is discarded
+ *     if the slot turned out to be torn or lapped
+ *   - A ring that already holds a valid header (daemon restart) is kept,
+ *     so its newest value is served immediately
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+
+#include "gatt/extension.hpp"
+#include "gatt/characteristic.hpp"
+#include "gatt/extension_ring.hpp"
+#include "gatt/service.hpp"
+#include "util/config.hpp"
+#include "util/log.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr const char* EXT_GROUP_PREFIX = "ext.";
+constexpr long DEFAULT_POLL_MS = 100;
+
+struct Extension {
+    std::string name;
+    std::string path;
+    provision_ext_ring* ring{nullptr};
+    std::uint64_t last_seq{0};
+
+    // NULL-terminated view over flag_names for export_characteristic().
+    std::vector<std::string> flag_names;
+    std::vector<const char*> flags;
+};
+
+static std::vector<Extension*> g_extensions;
+static std::vector<provision::gatt::ExtensionObject> g_objects;
+static guint g_poll_source = 0;
+
+/**
+ * Open (creating if needed) and map a ring; initialise it unless it
+ * already carries a valid header. nullptr on failure.
+ */
+provision_ext_ring* open_ring(const std::string& shm_name, mode_t mode)
+{
+    int fd = shm_open(shm_name.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, mode);
+    if (fd < 0) {
+        provision::log::error("ext: shm_open " + shm_name + ": " + std::strerror(errno));
+        return nullptr;
+    }
+
+    // shm_open honours the umask; producers in the group need write access.
+    fchmod(fd, mode);
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 ||
+        (static_cast<size_t>(st.st_size) < sizeof(provision_ext_ring) &&
+         ftruncate(fd, sizeof(provision_ext_ring)) != 0)) {
+        provision::log::error("ext: sizing " + shm_name + ": " + std::strerror(errno));
+        close(fd);
+        return nullptr;
+    }
+
+    void* mem = mmap(nullptr, sizeof(provision_ext_ring),
+                     PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (mem == MAP_FAILED) {
+        provision::log::error("ext: mmap " + shm_name + ": " + std::strerror(errno));
+        return nullptr;
+    }
+
+    auto* ring = static_cast<provision_ext_ring*>(mem);
+
+    const bool valid = provision_ext_ready(ring) &&
+                       ring->slot_count == PROVISION_EXT_SLOTS &&
+                       ring->slot_size == PROVISION_EXT_SLOT_SIZE;
+    if (!valid) {
+        std::memset(ring, 0, sizeof(*ring));
+        ring->version = PROVISION_EXT_VERSION;
+        ring->slot_count = PROVISION_EXT_SLOTS;
+        ring->slot_size = PROVISION_EXT_SLOT_SIZE;
+        // Producers wait for the magic; publish it last.
+        __atomic_store_n(&ring->magic, PROVISION_EXT_MAGIC, __ATOMIC_RELEASE);
+    }
+
+    return ring;
+}
+
+/**
+ * Copy entry seq out of the ring as an "ay". nullptr if the slot no
+ * longer (or not yet) holds that entry, or changed while copying.
+ */
+GVariant* read_entry(const provision_ext_ring* ring, std::uint64_t seq)
+{
+    const provision_ext_slot* slot = &ring->slots[seq % PROVISION_EXT_SLOTS];
+
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != seq)
+        return nullptr;
+
+    std::uint32_t len = __atomic_load_n(&slot->len, __ATOMIC_RELAXED);
+    if (len > PROVISION_EXT_SLOT_SIZE)
+        len = PROVISION_EXT_SLOT_SIZE;
+
+    GVariant* value = g_variant_ref_sink(
+        g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE, slot->data, len, 1));
+
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != seq) {
+        g_variant_unref(value);
+        return nullptr;
+    }
+
+    return value;
+}
+
+void poll_extension(Extension& ext, bool notify)
+{
+    const std::uint64_t head = __atomic_load_n(&ext.ring->head, __ATOMIC_ACQUIRE);
+    if (head == ext.last_seq)
+        return;
+
+    // Ring re-initialised underneath us (e.g. removed and recreated).
+    if (head < ext.last_seq)
+        ext.last_seq = 0;
+
+    // Entries older than one ring length have been overwritten.
+    std::uint64_t first = ext.last_seq + 1;
+    if (head >= PROVISION_EXT_SLOTS && first + PROVISION_EXT_SLOTS <= head)
+        first = head - PROVISION_EXT_SLOTS + 1;
+
+    GVariant* latest = nullptr;
+    for (std::uint64_t seq = notify ? first : head; seq <= head; ++seq) {
+        GVariant* value = read_entry(ext.ring, seq);
+        if (!value)
+            continue;
+
+        if (notify)
+            provision::gatt::notify_characteristic_value(
+                ext.path, value, provision::gatt::NotifyPriority::BULK);
+
+        if (latest)
+            g_variant_unref(latest);
+        latest = value;
+    }
+
+    ext.last_seq = head;
+
+    if (latest) {
+        provision::gatt::set_characteristic_value(ext.path, latest);
+        g_variant_unref(latest);
+    }
+}
+
+gboolean on_poll(gpointer)
+{
+    for (Extension* ext : g_extensions)
+        poll_extension(*ext, true);
+    return G_SOURCE_CONTINUE;
+}
+
+/**
+ * "read,notify" -> flag list; anything but read/notify is dropped.
+ */
+std::vector<std::string> parse_flags(const std::string& name, const std::string& spec)
+{
+    std::vector<std::string> out;
+
+    gchar** parts = g_strsplit(spec.c_str(), ",", -1);
+    for (gchar** p = parts; p && *p; ++p) {
+        g_strstrip(*p);
+        if (std::strcmp(*p, "read") == 0 || std::strcmp(*p, "notify") == 0)
+            out.emplace_back(*p);
+        else if (**p)
+            provision::log::warn("ext: " + name + ": flag '" + *p + "' not supported");
+    }
+    g_strfreev(parts);
+
+    return out;
+}
+
+Extension* load_extension(const std::string& group, size_t index)
+{
+    const std::string name = group.substr(std::strlen(EXT_GROUP_PREFIX));
+    const char* g = group.c_str();
+
+    const std::string uuid = provision::config::get_string(g, "uuid", "");
+    if (!g_uuid_string_is_valid(uuid.c_str())) {
+        provision::log::error("ext: " + name + ": missing or invalid uuid");
+        return nullptr;
+    }
+
+    auto flag_names = parse_flags(
+        name, provision::config::get_string(g, "flags", "read,notify"));
+    if (flag_names.empty()) {
+        provision::log::error("ext: " + name + ": no usable flags");
+        return nullptr;
+    }
+
+    const std::string shm_name =
+        provision::config::get_string(g, "shm", "/provision-ext-" + name);
+    const std::string mode_str = provision::config::get_string(g, "mode", "0660");
+    const auto mode = static_cast<mode_t>(std::strtol(mode_str.c_str(), nullptr, 8));
+
+    provision_ext_ring* ring = open_ring(shm_name, mode);
+    if (!ring)
+        return nullptr;
+
+    auto* ext = new Extension;
+    ext->name = name;
+    ext->path = std::string(provision::gatt::CHR_EXT_PREFIX) + std::to_string(index);
+    ext->ring = ring;
+    ext->flag_names = std::move(flag_names);
+    for (const auto& f : ext->flag_names)
+        ext->flags.push_back(f.c_str());
+    ext->flags.push_back(nullptr);
+
+    g_objects.push_back({uuid, ext->path});
+    provision::log::info("ext: " + name + " -> " + ext->path + " (" + shm_name + ")");
+    return ext;
+}
+
+} // namespace
+
+namespace provision::gatt {
+
+void export_extensions(GDBusConnection* system_bus)
+{
+    for (const auto& group : provision::config::groups()) {
+        if (group.rfind(EXT_GROUP_PREFIX, 0) != 0)
+            continue;
+
+        Extension* ext = load_extension(group, g_extensions.size());
+        if (!ext)
+            continue;
+
+        try {
+            export_characteristic(system_bus, g_objects.back().uuid, ext->path,
+                                  SERVICE_PATH, ext->flags.data(), nullptr);
+        } catch (const std::exception& ex) {
+            provision::log::error("ext: " + ext->name + ": " + ex.what());
+            munmap(ext->ring, sizeof(provision_ext_ring));
+            g_objects.pop_back();
+            delete ext;
+            continue;
+        }
+
+        // Serve whatever the producer already published; notify only
+        // what arrives from now on.
+        set_characteristic_value(ext->path,
+                                 g_variant_new_array(G_VARIANT_TYPE_BYTE, nullptr, 0));
+        poll_extension(*ext, false);
+
+        g_extensions.push_back(ext);
+    }
+
+    if (!g_extensions.empty() && !g_poll_source) {
+        const long poll_ms = provision::config::get_int("ext", "poll_ms", DEFAULT_POLL_MS);
+        g_poll_source = g_timeout_add(
+            static_cast<guint>(poll_ms > 0 ? poll_ms : DEFAULT_POLL_MS), on_poll, nullptr);
+    }
+}
+
+const std::vector<ExtensionObject>& extension_objects()
+{
+    return g_objects;
+}
+
+} // namespace provision::gatt
@@ -0,0 +1,59 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   Extension characteristics declared in config and fed by local
+ *   producers through shared-memory rings.
+ *
+ * Notes:
+ *   - One characteristic per [ext.<name>] group:
+ *       uuid  = 128-bit UUID (required)
+ *       flags = read,notify (default; read and/or notify only)
+ *       shm   = POSIX shm name (default /provision-ext-<name>)
+ *       mode  = octal permissions of the shm object (default 0660)
+ *   - The daemon creates the ring (layout: gatt/extension_ring.hpp);
+ *     application processes publish into it, no D-Bus involved
+ *   - Rings are polled every [ext] poll_ms (default 100); new entries
+ *     are notified on the BULK lane, ReadValue returns the newest one
+ *   - Exported as /org/bluez/provision/ext<N> under the provisioning
+ *     service
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+#pragma once
+
+#include <gio/gio.h>
+
+#include <string>
+#include <vector>
+
+namespace provision::gatt {
+
+struct ExtensionObject {
+    std::string uuid;
+    std::string path;
+};
+
+/**
+ * Create the rings and export the declared extension characteristics.
+ *
+ * A malformed group or an unusable ring is logged and skipped; the
+ * built-in characteristics are unaffected.
+ */
+void export_extensions(GDBusConnection* system_bus);
+
+/**
+ * Extension characteristics exported so far (for GetManagedObjects).
+ */
+const std::vector<ExtensionObject>& extension_objects();
+
+} // namespace provision::gatt
@@ -0,0 +1,100 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   Shared-memory ring behind an extension characteristic, and the
+ *   producer side of its protocol.
+ *
+ * Notes:
+ *   - Self-contained (no GLib, no daemon headers) so application
+ *     processes can include it as is; builds as C++ or C (GCC/Clang)
+ *   - The daemon creates and initialises the ring (POSIX shm, name from
+ *     [ext.<name>] shm); producers open it read-write and publish
+ *   - Single writer. Each slot is a seqlock: seq is 0 while the slot is
+ *     written and the entry's sequence number once complete; head is the
+ *     sequence number of the newest complete entry
+ *   - Readers copy a slot out and re-check seq; a lapped or torn slot is
+ *     skipped, never served
+ *
+ * Producer:
+ *   int fd = shm_open("/provision-ext-app", O_RDWR, 0);
+ *   auto* ring = static_cast<provision_ext_ring*>(
+ *       mmap(nullptr, sizeof(provision_ext_ring), PROT_READ | PROT_WRITE,
+ *            MAP_SHARED, fd, 0));
+ *   if (provision_ext_ready(ring))
+ *       provision_ext_publish(ring, "1.4.2", 5);
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROVISION_EXT_MAGIC     0x52584550u   /* "PEXR" little-endian */
+#define PROVISION_EXT_VERSION   1u
+#define PROVISION_EXT_SLOTS     8u
+#define PROVISION_EXT_SLOT_SIZE 244u          /* one notification at ATT MTU 247 */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct provision_ext_slot {
+    uint64_t seq;                           /* 0: being written */
+    uint32_t len;
+    uint8_t data[PROVISION_EXT_SLOT_SIZE];
+};
+
+struct provision_ext_ring {
+    uint32_t magic;                         /* set last by the daemon */
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t slot_size;
+    uint64_t head;                          /* newest complete entry, 0: none */
+    struct provision_ext_slot slots[PROVISION_EXT_SLOTS];
+};
+
+/** Non-zero once the daemon has initialised the ring. */
+static inline int provision_ext_ready(const struct provision_ext_ring* ring)
+{
+    return ring &&
+           __atomic_load_n(&ring->magic, __ATOMIC_ACQUIRE) == PROVISION_EXT_MAGIC &&
+           ring->version == PROVISION_EXT_VERSION;
+}
+
+/**
+ * Publish one value (truncated to PROVISION_EXT_SLOT_SIZE). Wait-free;
+ * must only ever be called by one writer per ring.
+ */
+static inline void provision_ext_publish(struct provision_ext_ring* ring,
+                                         const void* data, uint32_t len)
+{
+    const uint64_t seq = __atomic_load_n(&ring->head, __ATOMIC_RELAXED) + 1;
+    struct provision_ext_slot* slot = &ring->slots[seq % PROVISION_EXT_SLOTS];
+
+    if (len > PROVISION_EXT_SLOT_SIZE)
+        len = PROVISION_EXT_SLOT_SIZE;
+
+    __atomic_store_n(&slot->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    memcpy(slot->data, data, len);
+    slot->len = len;
+
+    __atomic_store_n(&slot->seq, seq, __ATOMIC_RELEASE);
+    __atomic_store_n(&ring->head, seq, __ATOMIC_RELEASE);
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
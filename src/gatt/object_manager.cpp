@@ -17,11 +17,14 @@
  */
 
 #include "gatt/object_manager.hpp"
+#include "gatt/characteristic.hpp"
+#include "gatt/extension.hpp"
 #include "gatt/service.hpp"
 #include "util/log.hpp"
 
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 namespace {
 
@@ -71,7 +74,7 @@ GVariant* make_service_props()
  */
 GVariant* make_char_props(const char* uuid,
                           const char* service_path,
-                          const char* const* flags)
+                          const std::vector<std::string>& flags)
 {
     // a{sv}
     GVariantBuilder props;
@@ -86,8 +89,8 @@ GVariant* make_char_props(const char* uuid,
     // Flags: as
     GVariantBuilder flags_b;
     g_variant_builder_init(&flags_b, G_VARIANT_TYPE("as"));
-    for (int i = 0; flags && flags[i]; i++) {
-        g_variant_builder_add(&flags_b, "s", flags[i]);
+    for (const auto& f : flags) {
+        g_variant_builder_add(&flags_b, "s", f.c_str());
     }
     GVariant* flags_v = g_variant_builder_end(&flags_b);
     g_variant_builder_add(&props, "{sv}", "Flags", flags_v);
@@ -142,8 +145,10 @@ void on_method_call(GDBusConnection*,
     }
 
     // --- DeviceInfo characteristic (read) ---
+    // Flags come from the exported characteristic so link security
+    // (encrypt-*) is reported consistently.
     {
-        static const char* flags[] = {"read", nullptr};
+        const auto flags = provision::gatt::characteristic_flags(provision::gatt::CHR_DEVINFO);
 
         GVariantBuilder ifaces;
         g_variant_builder_init(&ifaces, G_VARIANT_TYPE("a{sa{sv}}"));
@@ -162,7 +167,7 @@ void on_method_call(GDBusConnection*,
 
     // --- State characteristic (read, notify) ---
     {
-        static const char* flags[] = {"read", "notify", nullptr};
+        const auto flags = provision::gatt::characteristic_flags(provision::gatt::CHR_STATE);
 
         GVariantBuilder ifaces;
         g_variant_builder_init(&ifaces, G_VARIANT_TYPE("a{sa{sv}}"));
@@ -180,7 +185,7 @@ void on_method_call(GDBusConnection*,
     }
     // --- Command characteristic (write) ---
     {
-        static const char* flags[] = {"write", nullptr};
+        const auto flags = provision::gatt::characteristic_flags(provision::gatt::CHR_COMMAND);
 
         GVariantBuilder ifaces;
         g_variant_builder_init(&ifaces, G_VARIANT_TYPE("a{sa{sv}}"));
@@ -198,6 +203,24 @@ void on_method_call(GDBusConnection*,
                             g_variant_builder_end(&ifaces));
     }
 
+    // --- Extension characteristics (from config) ---
+    for (const auto& ext : provision::gatt::extension_objects()) {
+        const auto flags = provision::gatt::characteristic_flags(ext.path);
+
+        GVariantBuilder ifaces;
+        g_variant_builder_init(&ifaces, G_VARIANT_TYPE("a{sa{sv}}"));
+
+        g_variant_builder_add(&ifaces, "{s@a{sv}}",
+                              "org.bluez.GattCharacteristic1",
+                              make_char_props(ext.uuid.c_str(),
+                                              provision::gatt::SERVICE_PATH,
+                                              flags));
+
+        g_variant_builder_add(&objects, "{o@a{sa{sv}}}",
+                              ext.path.c_str(),
+                              g_variant_builder_end(&ifaces));
+    }
+
     provision::log::info("OM: building ifaces end variant");
 
     // Return as a single out arg in a tuple
@@ -63,6 +63,10 @@ inline constexpr const char* CHR_STATE =
 inline constexpr const char* CHR_COMMAND =
     "/org/bluez/provision/char2";
 
+// Extension characteristics from config: ext0, ext1, ... (gatt/extension.hpp)
+inline constexpr const char* CHR_EXT_PREFIX =
+    "/org/bluez/provision/ext";
+
 
 void export_service(GDBusConnection* system_bus);
 } // namespace provision::gatt
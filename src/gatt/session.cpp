@@ -0,0 +1,293 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   Implementation of resumable provisioning sessions.
+ *
+ * Notes:
+ *   - Main-context only (called from GATT handlers and State)
+ *   - Sessions are few and short-lived; a small map is enough
+ *   - A token replays the session's events (SSID, IP) to whoever
+ *     presents it, so tokens come from the kernel CSPRNG (getrandom)
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+
+#include "gatt/session.hpp"
+#include "util/log.hpp"
+#include "util/mem_governor.hpp"
+
+#include <glib.h>
+
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <map>
+
+#include <sys/random.h>
+
+namespace {
+
+// Events kept per session for replay.
+constexpr size_t SESSION_REPLAY_LIMIT = 32;
+
+// Sessions kept for resumption; the oldest is evicted beyond this.
+constexpr size_t SESSION_MAX = 4;
+
+// A session not touched for this long can no longer be resumed.
+constexpr gint64 SESSION_TTL_US = 10 * 60 * G_USEC_PER_SEC;
+
+struct ReplayEntry {
+    std::uint64_t seq;
+    std::string payload;
+};
+
+struct Session {
+    std::uint64_t next_seq{1};
+    std::deque<ReplayEntry> replay;
+    gint64 last_used{0};
+};
+
+static std::map<std::string, Session> g_sessions;
+static std::string g_current;      // most recent session (attached or not)
+static bool g_attached = false;
+
+size_t entry_cost(const ReplayEntry& entry)
+{
+    return sizeof(ReplayEntry) + entry.payload.capacity();
+}
+
+size_t replay_bytes()
+{
+    size_t bytes = 0;
+    for (const auto& kv : g_sessions) {
+        for (const auto& entry : kv.second.replay)
+            bytes += entry_cost(entry);
+    }
+    return bytes;
+}
+
+size_t evict_replay(size_t wanted);
+
+provision::mem::ConsumerId replay_consumer()
+{
+    static const provision::mem::ConsumerId id = provision::mem::register_consumer(
+        "session replay", provision::mem::Tier::REPLAY, evict_replay);
+    return id;
+}
+
+void account_replay()
+{
+    provision::mem::set_usage(replay_consumer(), replay_bytes());
+}
+
+/**
+ * Memory governor callback: other sessions' history goes first, then
+ * the oldest events of the current one. A client resuming past the
+ * trimmed range simply gets fewer missed events.
+ */
+size_t evict_replay(size_t wanted)
+{
+    size_t freed = 0;
+
+    for (auto& kv : g_sessions) {
+        if (freed >= wanted)
+            break;
+        if (kv.first == g_current)
+            continue;
+        for (const auto& entry : kv.second.replay)
+            freed += entry_cost(entry);
+        kv.second.replay.clear();
+    }
+
+    auto it = g_sessions.find(g_current);
+    if (it != g_sessions.end()) {
+        auto& replay = it->second.replay;
+        while (!replay.empty() && freed < wanted) {
+            freed += entry_cost(replay.front());
+            replay.pop_front();
+        }
+    }
+
+    account_replay();
+    return freed;
+}
+
+/**
+ * 64-bit token from the kernel CSPRNG, hex encoded. Empty if no entropy
+ * could be read (getrandom only fails before the pool is initialised
+ * or on a signal; neither should last).
+ */
+std::string make_token()
+{
+    guint8 raw[8];
+    size_t got = 0;
+
+    while (got < sizeof(raw)) {
+        ssize_t n = getrandom(raw + got, sizeof(raw) - got, 0);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            provision::log::error(std::string("session: getrandom: ") + std::strerror(errno));
+            return {};
+        }
+        got += static_cast<size_t>(n);
+    }
+
+    char buf[2 * sizeof(raw) + 1]{};
+    for (size_t i = 0; i < sizeof(raw); ++i)
+        g_snprintf(buf + 2 * i, 3, "%02x", raw[i]);
+    return buf;
+}
+
+void prune_sessions()
+{
+    const gint64 now = g_get_monotonic_time();
+
+    for (auto it = g_sessions.begin(); it != g_sessions.end();) {
+        if (it->first != g_current && now - it->second.last_used > SESSION_TTL_US)
+            it = g_sessions.erase(it);
+        else
+            ++it;
+    }
+
+    while (g_sessions.size() > SESSION_MAX) {
+        auto oldest = g_sessions.end();
+        for (auto it = g_sessions.begin(); it != g_sessions.end(); ++it) {
+            if (it->first == g_current)
+                continue;
+            if (oldest == g_sessions.end() ||
+                it->second.last_used < oldest->second.last_used)
+                oldest = it;
+        }
+        if (oldest == g_sessions.end())
+            break;
+        g_sessions.erase(oldest);
+    }
+
+    account_replay();
+}
+
+/**
+ * Insert "seq":N as the first member of a JSON object payload.
+ */
+std::string stamp_seq(const std::string& payload, std::uint64_t seq)
+{
+    if (payload.empty() || payload[0] != '{')
+        return payload;
+
+    std::string member = "\"seq\":" + std::to_string(seq);
+    if (payload.size() > 1 && payload[1] != '}')
+        member += ",";
+
+    return "{" + member + payload.substr(1);
+}
+
+} // namespace
+
+namespace provision::gatt {
+
+bool session_attached()
+{
+    return g_attached && !g_current.empty();
+}
+
+std::string session_begin()
+{
+    std::string token = make_token();
+    while (!token.empty() && g_sessions.count(token))
+        token = make_token();
+
+    if (token.empty())
+        return token;
+
+    Session s;
+    s.last_used = g_get_monotonic_time();
+    g_sessions.emplace(token, std::move(s));
+
+    g_current = token;
+    g_attached = true;
+    prune_sessions();
+
+    provision::log::info("session: issued token " + token);
+    return token;
+}
+
+bool session_resume(const std::string& token,
+                    std::uint64_t last_seq,
+                    std::vector<std::string>& missed)
+{
+    prune_sessions();
+
+    auto it = g_sessions.find(token);
+    if (it == g_sessions.end()) {
+        provision::log::warn("session: resume with unknown token " + token);
+        return false;
+    }
+
+    Session& s = it->second;
+    s.last_used = g_get_monotonic_time();
+
+    missed.clear();
+    for (const auto& entry : s.replay) {
+        if (entry.seq > last_seq)
+            missed.push_back(entry.payload);
+    }
+
+    g_current = token;
+    g_attached = true;
+
+    provision::log::info(
+        "session: resumed " + token +
+        " last_seq=" + std::to_string(last_seq) +
+        " replay=" + std::to_string(missed.size()));
+    return true;
+}
+
+void session_detach()
+{
+    if (!g_attached)
+        return;
+
+    g_attached = false;
+
+    auto it = g_sessions.find(g_current);
+    if (it != g_sessions.end())
+        it->second.last_used = g_get_monotonic_time();
+
+    provision::log::info("session: link detached from " + g_current);
+}
+
+std::string session_token()
+{
+    return g_current;
+}
+
+std::string session_record(const std::string& payload)
+{
+    auto it = g_sessions.find(g_current);
+    if (it == g_sessions.end())
+        return payload;
+
+    Session& s = it->second;
+    const std::uint64_t seq = s.next_seq++;
+    std::string stamped = stamp_seq(payload, seq);
+
+    s.replay.push_back(ReplayEntry{seq, stamped});
+    if (s.replay.size() > SESSION_REPLAY_LIMIT)
+        s.replay.pop_front();
+
+    account_replay();
+    return stamped;
+}
+
+} // namespace provision::gatt
@@ -0,0 +1,84 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   Provisioning sessions that survive BLE link drops.
+ *
+ * Notes:
+ *   - A short token is issued on the first command of a link
+ *   - Every State event is stamped with a per-session sequence number and
+ *     kept in a small replay buffer
+ *   - A reconnecting client presents {token, last seq} to rebind and
+ *     receive the events it missed
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace provision::gatt {
+
+/**
+ * Upper bound of what session_record() adds to a payload:
+ * "seq":<20-digit uint64>, (payloads sized for one notification must
+ * leave this much room).
+ */
+inline constexpr std::size_t SESSION_STAMP_MAX_BYTES = 27;
+
+/**
+ * Return true if the current link is bound to a session.
+ */
+bool session_attached();
+
+/**
+ * Start a new session and bind the current link to it.
+ * Returns the new token, or empty (and starts nothing) if no random
+ * token could be generated.
+ */
+std::string session_begin();
+
+/**
+ * Rebind the current link to an existing session.
+ *
+ * On success, `missed` receives the stamped events with seq > last_seq
+ * (oldest first) and true is returned. Unknown or expired tokens return
+ * false and leave the current binding unchanged.
+ */
+bool session_resume(const std::string& token,
+                    std::uint64_t last_seq,
+                    std::vector<std::string>& missed);
+
+/**
+ * Mark the current link as gone. The session stays resumable until it
+ * expires; events keep being recorded into it.
+ */
+void session_detach();
+
+/**
+ * Token of the current session, or empty if none was ever started.
+ */
+std::string session_token();
+
+/**
+ * Stamp a JSON object payload with the next sequence number of the
+ * current session and record it for replay.
+ *
+ * Returns the payload unchanged if no session exists yet.
+ */
+std::string session_record(const std::string& payload);
+
+} // namespace provision::gatt
@@ -24,9 +24,12 @@
 #include "gatt/state.hpp"
 #include "gatt/characteristic.hpp"
 #include "gatt/service.hpp"
+#include "gatt/session.hpp"
 #include "wifi/scan.hpp"
 #include "wifi/connect.hpp"
 #include "util/log.hpp"
+#include "util/metrics.hpp"
+#include "util/trace.hpp"
 #include "wifi/wifi_state_dispatcher.hpp"
 
 #include <string>
@@ -40,6 +43,16 @@ namespace {
 
 static std::string g_state = "UNCONFIGURED";
 
+// Credentials of the connect attempt in flight (valid while CONNECTING).
+static std::string g_connecting_ssid;
+static std::string g_connecting_psk;
+
+// Start of the connect attempt in flight (monotonic us), 0 if none.
+static gint64 g_connect_started_us = 0;
+
+// Local consumers of the State event stream (e.g. control socket).
+static std::vector<provision::gatt::StateListener> g_listeners;
+
 // -----------------------------------------------------------------------------
 // Helpers
 // -----------------------------------------------------------------------------
@@ -55,24 +68,52 @@ GVariant* make_ay_from_string(const char* str)
     return g_variant_builder_end(&b);
 }
 
+std::string state_json(const std::string& state)
+{
+    return "{\"state\":\"" + state + "\"}";
+}
+
 GVariant* make_state_payload(const std::string& state)
 {
-    std::string json = "{\"state\":\"" + state + "\"}";
-    return make_ay_from_string(json.c_str());
+    return make_ay_from_string(state_json(state).c_str());
 }
 
-void notify_state()
+/**
+ * Notify a payload on the State characteristic as-is.
+ */
+void send_payload(const std::string& payload, provision::gatt::NotifyPriority priority)
 {
-    GVariant* value = make_state_payload(g_state);
+    GVariant* value = g_variant_ref_sink(make_ay_from_string(payload.c_str()));
 
     provision::gatt::notify_characteristic_value(
         provision::gatt::CHR_STATE,
-        value
+        value,
+        priority
     );
 
     g_variant_unref(value);
 }
 
+/**
+ * Stamp a State event with the session sequence number, record it for
+ * replay, then notify it.
+ */
+void publish(const std::string& payload, provision::gatt::NotifyPriority priority)
+{
+    std::string stamped = provision::gatt::session_record(payload);
+
+    for (auto listener : g_listeners)
+        listener(stamped);
+
+    send_payload(stamped, priority);
+}
+
+void notify_state(provision::gatt::NotifyPriority priority =
+                      provision::gatt::NotifyPriority::CONTROL)
+{
+    publish(state_json(g_state), priority);
+}
+
 GVariant* on_read_state()
 {
     provision::log::info("State ReadValue");
@@ -83,6 +124,10 @@ void on_state_notify(bool enabled)
 {
     if (!enabled) {
         provision::log::info("State notify DISABLED by client");
+
+        // BlueZ calls StopNotify when the link drops; keep the session
+        // resumable and keep recording events into it.
+        provision::gatt::session_detach();
         return;
     }
 
@@ -110,6 +155,10 @@ static const char* FLAGS[] = {
 // Conservative single-chunk payload limit (bytes)
 constexpr size_t MAX_NOTIFY_BYTES = 200;
 
+// Budget for payloads that go through publish(), which stamps them.
+constexpr size_t MAX_PUBLISH_BYTES =
+    MAX_NOTIFY_BYTES - provision::gatt::SESSION_STAMP_MAX_BYTES;
+
 static std::string json_escape(const std::string& in)
 {
     std::string out;
@@ -139,8 +188,8 @@ static std::string build_wifi_scan_payload(const std::vector<std::string>& ssids
         std::string entry =
             (first ? "" : ",") + std::string("\"") + json_escape(ssid) + "\"";
 
-        // +2 for closing "]}"
-        if (payload.size() + entry.size() + 2 > MAX_NOTIFY_BYTES)
+        // +2 for closing "]}"; room is left for the session seq stamp.
+        if (payload.size() + entry.size() + 2 > MAX_PUBLISH_BYTES)
             break;
 
         payload += entry;
@@ -169,46 +218,70 @@ void handle_wifi_scan_request()
     notify_state();
 
     // 2. Perform scan
+    PROVISION_TRACE0(scan_start);
+    const gint64 scan_start = g_get_monotonic_time();
     std::vector<std::string> ssids = provision::wifi::scan_ssids();
+    const gint64 scan_us = g_get_monotonic_time() - scan_start;
+    provision::metrics::observe(provision::metrics::Histogram::SCAN_SECONDS,
+                                scan_us / 1e6);
+    PROVISION_TRACE2(scan_done, ssids.size(), scan_us);
 
     provision::log::info(
         "wifi_scan: completed, ssid_count=" + std::to_string(ssids.size()));
 
     // 3. Notify SSID payload
     std::string payload = build_wifi_scan_payload(ssids);
-    GVariant* value = make_ay_from_string(payload.c_str());
 
     provision::log::info("wifi_scan: notifying SSID payload");
-    notify_characteristic_value(CHR_STATE, value);
-    g_variant_unref(value);
+    publish(payload, NotifyPriority::INTERACTIVE);
 
     // 4. Notify SCAN_COMPLETE
+    // Same lane as the results so it can never overtake them.
     g_state = "SCAN_COMPLETE";
-    notify_state();
+    notify_state(NotifyPriority::INTERACTIVE);
 }
 
 void notify_state_connected(const std::string& ssid,
-                            const std::string& ip)
+                            const std::string& ip,
+                            const std::string& mdns)
 {
     provision::log::info(
         "notify_state_connected: ssid=" + ssid + " ip=" + ip);
 
     // Update global state
     g_state = "CONNECTED";
+    g_connecting_psk.clear();
+
+    if (g_connect_started_us) {
+        const gint64 elapsed_us = g_get_monotonic_time() - g_connect_started_us;
+        PROVISION_TRACE2(connect_done, ssid.c_str(), elapsed_us);
+        provision::metrics::observe(provision::metrics::Histogram::PROVISION_SECONDS,
+                                    elapsed_us / 1e6);
+        provision::metrics::inc(provision::metrics::Counter::CONNECT_SUCCESS);
+        g_connect_started_us = 0;
+    }
 
     // Build JSON payload
     std::string payload =
         "{"
         "\"state\":\"CONNECTED\","
         "\"ssid\":\"" + json_escape(ssid) + "\","
-        "\"ip\":\"" + json_escape(ip) + "\""
-        "}";
+        "\"ip\":\"" + json_escape(ip) + "\"";
 
-    GVariant* value = make_ay_from_string(payload.c_str());
+    if (!mdns.empty())
+        payload += ",\"mdns\":\"" + json_escape(mdns) + "\"";
 
-    notify_characteristic_value(CHR_STATE, value);
+    payload += "}";
 
-    g_variant_unref(value);
+    publish(payload, NotifyPriority::CONTROL);
+}
+
+void notify_state_recovery()
+{
+    provision::log::info("notify_state_recovery: connectivity lost, provisioning re-armed");
+
+    g_state = "RECOVERY";
+    notify_state();
 }
 
 void handle_wifi_connect_request(const std::string& ssid,
@@ -216,15 +289,88 @@ void handle_wifi_connect_request(const std::string& ssid,
 {
     provision::log::info("wifi_connect: request received");
 
+    // A client that resumed its session may repeat the request it lost the
+    // answer to; let the attempt in flight finish instead of restarting it.
+    // A corrected PSK is a new attempt.
+    if (g_state == "CONNECTING" && ssid == g_connecting_ssid && psk == g_connecting_psk) {
+        provision::log::info("wifi_connect: already connecting to " + ssid);
+        notify_state();
+        return;
+    }
+
+    g_connecting_ssid = ssid;
+    g_connecting_psk = psk;
     g_state = "CONNECTING";
+    g_connect_started_us = g_get_monotonic_time();
+    provision::metrics::inc(provision::metrics::Counter::CONNECT_ATTEMPTS);
+    PROVISION_TRACE2(connect_phase, ssid.c_str(), "request");
     notify_state();
 
     auto result = provision::wifi::connect(ssid, psk);
 
-    if (result != provision::wifi::ConnectResult::REQUESTED) {
-        g_state = "UNCONFIGURED";
-        notify_state();
+    if (result != provision::wifi::ConnectResult::REQUESTED)
+        notify_state_connect_failed(ssid, "request failed");
+}
+
+void notify_state_connect_failed(const std::string& ssid, const std::string& reason)
+{
+    // A late failure of an attempt that was already replaced or finished.
+    if (g_state != "CONNECTING" || ssid != g_connecting_ssid)
+        return;
+
+    provision::log::warn("wifi_connect: failed ssid=" + ssid + ": " + reason);
+    PROVISION_TRACE2(connect_phase, ssid.c_str(), "failed");
+
+    g_connect_started_us = 0;
+    g_connecting_ssid.clear();
+    g_connecting_psk.clear();
+    g_state = "UNCONFIGURED";
+    notify_state();
+}
+
+void handle_status_request()
+{
+    notify_state();
+}
+
+void add_state_listener(StateListener listener)
+{
+    if (listener)
+        g_listeners.push_back(listener);
+}
+
+void ensure_session()
+{
+    if (session_attached())
+        return;
+
+    std::string token = session_begin();
+    if (token.empty())
+        return;
+
+    send_payload("{\"op\":\"session\",\"token\":\"" + token + "\"}",
+         NotifyPriority::CONTROL);
+}
+
+void handle_session_resume(const std::string& token, std::uint64_t last_seq)
+{
+    std::vector<std::string> missed;
+
+    if (!session_resume(token, last_seq, missed)) {
+        send_payload("{\"op\":\"session\",\"error\":\"unknown_token\"}",
+             NotifyPriority::CONTROL);
+        session_detach();
+        ensure_session();
+        return;
     }
+
+    send_payload("{\"op\":\"session\",\"token\":\"" + json_escape(token) + "\","
+         "\"resumed\":true,\"state\":\"" + g_state + "\"}",
+         NotifyPriority::CONTROL);
+
+    // Replayed events keep their original seq; one lane keeps them ordered.
+    for (const auto& payload : missed)
+        send_payload(payload, NotifyPriority::INTERACTIVE);
 }
 
 void export_state(GDBusConnection* system_bus)
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <gio/gio.h>
+#include <cstdint>
 #include <string>  
 namespace provision::gatt {
 
@@ -39,8 +40,53 @@ void handle_wifi_scan_request();
 void handle_wifi_connect_request(const std::string& ssid,
                                  const std::string& psk);
 
+/**
+ * The connect attempt for ssid failed after it was requested (wrong key,
+ * AP gone, ...): back to UNCONFIGURED so the client can retry.
+ * Ignored unless that attempt is still the one in flight.
+ */
+void notify_state_connect_failed(const std::string& ssid, const std::string& reason);
+
+/**
+ * Publish CONNECTED. mdns (e.g. "raspberrypi.local") is included when
+ * the built-in responder announced a name.
+ */
 void notify_state_connected(const std::string& ssid,
-                            const std::string& ip);
+                            const std::string& ip,
+                            const std::string& mdns = {});
+
+/**
+ * Publish RECOVERY: Wi-Fi connectivity was lost for longer than the
+ * watchdog grace period and provisioning is available again.
+ */
+void notify_state_recovery();
+
+/**
+ * Re-publish the current provisioning state.
+ */
+void handle_status_request();
+
+/**
+ * State event listener.
+ *
+ * Receives every State event payload (JSON, session-stamped) as it is
+ * published, regardless of BLE notification state.
+ */
+using StateListener = void (*)(const std::string& payload);
+
+void add_state_listener(StateListener listener);
+
+/**
+ * Bind the current link to a session, issuing a new token (notified as
+ * {"op":"session","token":...}) if it is not bound yet.
+ */
+void ensure_session();
+
+/**
+ * Rebind the current link to a previous session and replay the State
+ * events it missed since last_seq. Unknown tokens start a new session.
+ */
+void handle_session_resume(const std::string& token, std::uint64_t last_seq);
 
 
 } // namespace provision::gatt
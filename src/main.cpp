@@ -17,84 +17,76 @@
  */
 
 #include <gio/gio.h>
+#include <glib-unix.h>
+#include <csignal>
+#include <cstring>
 #include <stdexcept>
 #include <string>
 
+#include "util/blocking_probe.hpp"
+#include "util/config.hpp"
 #include "util/log.hpp"
-#include "dbus/bluez_client.hpp"
+#include "util/mem_governor.hpp"
+#include "dbus/agent.hpp"
+#include "dbus/registration.hpp"
 
+#include "gatt/characteristic.hpp"
 #include "gatt/object_manager.hpp"
 #include "gatt/service.hpp"
 #include "gatt/device_info.hpp"
 #include "gatt/state.hpp"
 #include "gatt/command.hpp"
+#include "gatt/extension.hpp"
 
 #include "adv/advertisement.hpp"
+#include "bench/hw_bench.hpp"
+#include "ctl/config_drop.hpp"
+#include "ctl/control_socket.hpp"
+#include "ctl/metrics_server.hpp"
+#include "wifi/connectivity_watchdog.hpp"
 #include "wifi/ip_monitor.hpp"
+#include "wifi/mdns.hpp"
+#include "wifi/sim_backend.hpp"
 #include "wifi/wifi_state_dispatcher.hpp"
 
 
-
-namespace {
-
-constexpr const char* ADV_PATH = "/org/bluez/provision/advertisement0";
-
-struct RegistrationCtx {
-    GDBusConnection* bus;
-    std::string adapter_path;
-};
-
-// Helper to ensure we free ctx exactly once.
-void free_ctx(RegistrationCtx* ctx)
+/*
+ * SIGTERM / SIGINT: leave the main loop so main() can clean up and
+ * report its exit status (systemctl stop, Ctrl-C, test harnesses).
+ */
+static gboolean on_quit_signal(gpointer user_data)
 {
-    delete ctx;
+    provision::log::info("provision-ble: signal received, shutting down");
+    g_main_loop_quit(static_cast<GMainLoop*>(user_data));
+    return G_SOURCE_CONTINUE;
 }
 
-gboolean start_async_registration(gpointer user_data)
+int main(int argc, char** argv)
 {
-    auto* ctx = static_cast<RegistrationCtx*>(user_data);
-
-    provision::bluez::register_gatt_application_async(
-        ctx->bus,
-        ctx->adapter_path,
-        provision::gatt::APP_PATH,
-        [ctx](bool ok, const std::string& err) {
-            if (!ok) {
-                provision::log::error("RegisterApplication failed: " + err);
-                free_ctx(ctx);
-                return;
-            }
-
-            provision::log::info("GATT application registered");
-
-            provision::bluez::register_advertisement_async(
-                ctx->bus,
-                ctx->adapter_path,
-                ADV_PATH,
-                [ctx](bool ok2, const std::string& err2) {
-                    if (!ok2) {
-                        provision::log::error("RegisterAdvertisement failed: " + err2);
-                        free_ctx(ctx);
-                        return;
-                    }
-
-                    provision::log::info("Advertisement registered");
-                    free_ctx(ctx);
-                }
-            );
-        }
-    );
-
-    // Run once; DO NOT free ctx here. It must outlive async callbacks.
-    return G_SOURCE_REMOVE;
-}
+    // On-device benchmark instead of the daemon
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0)
+        return provision::bench::run(argc - 2, argv + 2);
 
-} // namespace
+#ifdef PROVISION_BLOCKING_DETECTOR
+    // Before anything that is probed (log init, config read).
+    provision::blocking::init();
+#endif
 
-int main()
-{
-    provision::log::init("/var/log/provision/ble.log");
+    provision::log::init(provision::log::DEFAULT_LOG_PATH);
     provision::log::info("provision-ble starting (Milestone 4)");
+    provision::config::load();
+
+    // Per-instance overrides (fleet simulator runs many daemons side by side)
+    const std::string log_path =
+        provision::config::get_string("log", "path", provision::log::DEFAULT_LOG_PATH);
+    if (log_path != provision::log::DEFAULT_LOG_PATH)
+        provision::log::init(log_path);
+#ifdef PROVISION_BLOCKING_DETECTOR
+    provision::blocking::configure();
+#endif
+
+    // One ceiling for scan cache, replay buffers and notify backlog.
+    provision::mem::start_memory_governor();
 
     GError* err = nullptr;
     GDBusConnection* bus = g_bus_get_sync(G_BUS_TYPE_SYSTEM, nullptr, &err);
@@ -104,10 +96,23 @@ int main()
         if (err) g_error_free(err);
         return 1;
     }
-    // Set BLE pairing name BEFORE advertising
-    provision::adv::set_ble_alias(bus, "PiDevelopDotcom");
-    provision::wifi::start_ip_monitor();
+    provision::wifi::init_mdns(bus);
+    if (!provision::wifi::sim_backend_enabled())
+        provision::wifi::start_ip_monitor();
     provision::wifi::init_wifi_state_dispatcher();
+    // Pairing agent + link security must be in place before the first
+    // client can touch a characteristic.
+    provision::bluez::start_agent(bus);
+
+    const std::string link = provision::config::get_string("security", "link", "none");
+    if (link == "encrypt")
+        provision::gatt::set_link_security(provision::gatt::LinkSecurity::ENCRYPT);
+    else if (link == "authenticated")
+        provision::gatt::set_link_security(provision::gatt::LinkSecurity::AUTHENTICATED);
+
+    provision::gatt::set_notify_fast_path(
+        provision::config::get_bool("gatt", "notify_fast_path", true));
+
     try {
         // 1) Export objects
         provision::gatt::export_object_manager(bus);
@@ -115,28 +120,39 @@ int main()
         provision::gatt::export_device_info(bus);
         provision::gatt::export_state(bus);
         provision::gatt::export_command(bus);
+        provision::gatt::export_extensions(bus);
         provision::adv::export_advertisement(bus);
-        
 
+        // Local control path (provision-ctl); non-fatal if unavailable
+        const std::string ctl_path = provision::config::get_string(
+            "ctl", "socket", provision::ctl::CONTROL_SOCKET_PATH);
+        provision::ctl::start_control_socket(ctl_path.c_str());
 
-        // 2) Find adapter
-        auto adapter = provision::bluez::find_adapter(bus);
+        // Fleet monitoring scrape endpoint ([metrics] enabled)
+        provision::ctl::start_metrics_server();
 
-        // 3) Main loop first
-        GMainLoop* loop = g_main_loop_new(nullptr, FALSE);
+        // Pre-staged credentials skip advertising entirely.
+        provision::ctl::apply_config_drop();
 
-        // IMPORTANT: ctx must survive until both async registrations finish.
-        auto* reg_ctx = new RegistrationCtx{
-            bus,
-            adapter.adapter_path
-        };
 
-        // Schedule registration. No destroy-notify here.
-        g_idle_add(start_async_registration, reg_ctx);
+        // 2) Register with bluetoothd once the adapter is powered, and
+        //    again after every bluetoothd restart.
+        provision::bluez::start_registration(
+            bus, provision::config::get_string("adapter", "alias", "PiDevelopDotcom"));
+
+        // Leaves provisioning once online, re-arms on sustained loss.
+        provision::wifi::start_connectivity_watchdog();
+
+        // 3) Main loop
+        GMainLoop* loop = g_main_loop_new(nullptr, FALSE);
+        const guint sigterm_source = g_unix_signal_add(SIGTERM, on_quit_signal, loop);
+        const guint sigint_source = g_unix_signal_add(SIGINT, on_quit_signal, loop);
 
         provision::log::info("Entering main loop");
         g_main_loop_run(loop);
 
+        g_source_remove(sigterm_source);
+        g_source_remove(sigint_source);
         g_main_loop_unref(loop);
     }
     catch (const std::exception& ex) {
@@ -146,5 +162,24 @@ int main()
     }
 
     g_object_unref(bus);
+
+#ifdef PROVISION_BLOCKING_DETECTOR
+    if (provision::blocking::known_count() > 0) {
+        provision::log::info(
+            "blocking detector: " +
+            std::to_string(provision::blocking::known_count()) +
+            " known baseline call(s), not counted");
+    }
+
+    // Non-zero exit lets a stand-in test run fail on violations.
+    if (provision::blocking::violation_count() > 0) {
+        provision::log::error(
+            "blocking detector: " +
+            std::to_string(provision::blocking::violation_count()) +
+            " violation(s)");
+        return 3;
+    }
+#endif
+
     return 0;
 }
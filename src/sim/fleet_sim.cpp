@@ -0,0 +1,869 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   provision-fleet: run many provision-ble instances against one fake
+ *   BlueZ on a private bus and measure provisioning throughput.
+ *
+ * Usage:
+ *   provision-fleet [-n instances] [-d daemon] [-w workdir] [-r spawn_per_s]
+ *                   [-c connect_ms] [-t timeout_s]
+ *
+ * Notes:
+ *   - Starts a private dbus-daemon (GTestDBus) and owns org.bluez on it.
+ *     Every instance gets its own adapter (/org/bluez/hciN), alias,
+ *     log, control socket and simulated Wi-Fi ([wifi] backend=sim)
+ *   - The fake BlueZ plays the phone too: once an instance registers its
+ *     GATT application it walks the object tree, enables State notify
+ *     and writes a wifi_connect to Command, then waits for CONNECTED
+ *   - Each daemon is its own process (its state is process-global), so
+ *     per-instance cost is read from /proc/<pid>
+ *   - Prints one JSON report on stdout; exit 0 if every instance reached
+ *     CONNECTED before the timeout, 1 otherwise, 2 on usage errors
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+
+#include "gatt/service.hpp"
+
+#include <gio/gio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <signal.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr const char* SIM_SSID = "SimNet";
+constexpr const char* SIM_PSK = "simulated-psk";
+
+struct Options {
+    int instances{20};
+    std::string daemon{"./provision-ble"};
+    std::string workdir;
+    double spawn_per_s{0};   // 0: all at once
+    int connect_ms{500};
+    int timeout_s{120};
+};
+
+struct Instance {
+    int index{0};
+    std::string adapter_path;
+    GPid pid{0};
+    bool exited{false};
+    std::string owner;       // unique bus name, known after RegisterApplication
+    std::string alias;
+    guint state_sub{0};
+
+    gint64 t_spawn{0};
+    gint64 t_app{0};         // RegisterApplication
+    gint64 t_adv{0};         // RegisterAdvertisement
+    gint64 t_connect{0};     // wifi_connect written
+    gint64 t_connected{0};   // CONNECTED notified
+
+    long rss_kb{0};
+    long hwm_kb{0};
+    double cpu_ms{0};
+    int gatt_objects{0};
+};
+
+Options g_opt;
+std::vector<Instance> g_inst;
+GDBusConnection* g_bus = nullptr;
+GMainLoop* g_loop = nullptr;
+int g_done = 0;
+int g_next_spawn = 0;
+gint64 g_t0 = 0;
+
+// Our own connection only (stand-in BlueZ + phone); bus-wide load is
+// bus_serial().
+std::atomic<unsigned long> g_msgs_in{0};
+std::atomic<unsigned long> g_msgs_out{0};
+
+// -----------------------------------------------------------------------------
+// Helpers
+// -----------------------------------------------------------------------------
+
+void usage()
+{
+    std::fprintf(stderr,
+        "usage: provision-fleet [options]\n"
+        "  -n N        daemon instances (default 20)\n"
+        "  -d path     provision-ble binary (default ./provision-ble)\n"
+        "  -w dir      work dir for configs/logs/sockets (default: temp dir)\n"
+        "  -r rate     spawn rate in instances/s (default: all at once)\n"
+        "  -c ms       simulated Wi-Fi connect time (default 500)\n"
+        "  -t seconds  overall timeout (default 120)\n");
+}
+
+double ms_since(gint64 from, gint64 to)
+{
+    return (from && to) ? static_cast<double>(to - from) / 1000.0 : -1.0;
+}
+
+Instance* by_adapter(const char* path)
+{
+    for (auto& inst : g_inst) {
+        if (inst.adapter_path == path)
+            return &inst;
+    }
+    return nullptr;
+}
+
+Instance* by_owner(const char* owner)
+{
+    for (auto& inst : g_inst) {
+        if (inst.owner == owner)
+            return &inst;
+    }
+    return nullptr;
+}
+
+/**
+ * Resident/peak memory and CPU time of pid from /proc.
+ */
+void sample_proc(Instance& inst)
+{
+    if (inst.exited || inst.pid <= 0)
+        return;
+
+    const std::string base = "/proc/" + std::to_string(inst.pid);
+
+    std::ifstream status(base + "/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmRSS:", 0) == 0)
+            inst.rss_kb = std::atol(line.c_str() + 6);
+        else if (line.rfind("VmHWM:", 0) == 0)
+            inst.hwm_kb = std::atol(line.c_str() + 6);
+    }
+
+    // utime and stime are fields 14 and 15; skip past "(comm)" first.
+    std::ifstream stat(base + "/stat");
+    std::string all((std::istreambuf_iterator<char>(stat)), std::istreambuf_iterator<char>());
+    size_t rp = all.rfind(')');
+    if (rp == std::string::npos)
+        return;
+
+    std::istringstream fields(all.substr(rp + 2));
+    std::string f;
+    unsigned long utime = 0, stime = 0;
+    for (int i = 3; fields >> f; ++i) {
+        if (i == 14) utime = std::strtoul(f.c_str(), nullptr, 10);
+        if (i == 15) { stime = std::strtoul(f.c_str(), nullptr, 10); break; }
+    }
+    inst.cpu_ms = static_cast<double>(utime + stime) * 1000.0 /
+                  static_cast<double>(sysconf(_SC_CLK_TCK));
+}
+
+GVariant* make_ay(const std::string& s)
+{
+    return g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE, s.data(), s.size(), 1);
+}
+
+// -----------------------------------------------------------------------------
+// Client side (what a phone would do)
+// -----------------------------------------------------------------------------
+
+void on_state_changed(GDBusConnection*,
+                      const gchar* sender,
+                      const gchar*,
+                      const gchar*,
+                      const gchar*,
+                      GVariant* parameters,
+                      gpointer)
+{
+    Instance* inst = by_owner(sender);
+    if (!inst || inst->t_connected)
+        return;
+
+    GVariant* changed = nullptr;
+    g_variant_get(parameters, "(&s@a{sv}@as)", nullptr, &changed, nullptr);
+    if (!changed)
+        return;
+
+    GVariant* value = g_variant_lookup_value(changed, "Value", G_VARIANT_TYPE_BYTESTRING);
+    g_variant_unref(changed);
+    if (!value)
+        return;
+
+    gsize len = 0;
+    const char* data = static_cast<const char*>(
+        g_variant_get_fixed_array(value, &len, 1));
+    const std::string payload(data, len);
+    g_variant_unref(value);
+
+    if (payload.find("\"state\":\"CONNECTED\"") == std::string::npos)
+        return;
+
+    inst->t_connected = g_get_monotonic_time();
+    sample_proc(*inst);
+
+    if (++g_done == g_opt.instances)
+        g_main_loop_quit(g_loop);
+}
+
+void on_call_done(GObject* source, GAsyncResult* res, gpointer user_data)
+{
+    const char* what = static_cast<const char*>(user_data);
+
+    GError* err = nullptr;
+    GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), res, &err);
+    if (reply) {
+        g_variant_unref(reply);
+        return;
+    }
+
+    std::fprintf(stderr, "provision-fleet: %s failed: %s\n",
+                 what, err && err->message ? err->message : "unknown error");
+    if (err) g_error_free(err);
+}
+
+void on_notify_started(GObject* source, GAsyncResult* res, gpointer user_data)
+{
+    auto* inst = &g_inst[GPOINTER_TO_INT(user_data)];
+
+    GError* err = nullptr;
+    GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), res, &err);
+    if (!reply) {
+        std::fprintf(stderr, "provision-fleet: #%d StartNotify failed: %s\n",
+                     inst->index, err && err->message ? err->message : "unknown error");
+        if (err) g_error_free(err);
+        return;
+    }
+    g_variant_unref(reply);
+
+    const std::string cmd = std::string("{\"op\":\"wifi_connect\",\"ssid\":\"") +
+                            SIM_SSID + "\",\"psk\":\"" + SIM_PSK + "\"}";
+
+    inst->t_connect = g_get_monotonic_time();
+    g_dbus_connection_call(
+        g_bus,
+        inst->owner.c_str(),
+        provision::gatt::CHR_COMMAND,
+        "org.bluez.GattCharacteristic1",
+        "WriteValue",
+        g_variant_new("(@ay@a{sv})", make_ay(cmd),
+                      g_variant_new_array(G_VARIANT_TYPE("{sv}"), nullptr, 0)),
+        nullptr,
+        G_DBUS_CALL_FLAGS_NONE,
+        -1,
+        nullptr,
+        on_call_done,
+        const_cast<char*>("WriteValue")
+    );
+}
+
+void on_app_objects(GObject* source, GAsyncResult* res, gpointer user_data)
+{
+    auto* inst = &g_inst[GPOINTER_TO_INT(user_data)];
+
+    GError* err = nullptr;
+    GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), res, &err);
+    if (!reply) {
+        std::fprintf(stderr, "provision-fleet: #%d GetManagedObjects failed: %s\n",
+                     inst->index, err && err->message ? err->message : "unknown error");
+        if (err) g_error_free(err);
+        return;
+    }
+
+    GVariant* objects = g_variant_get_child_value(reply, 0);
+    inst->gatt_objects = static_cast<int>(g_variant_n_children(objects));
+    g_variant_unref(objects);
+    g_variant_unref(reply);
+
+    inst->state_sub = g_dbus_connection_signal_subscribe(
+        g_bus,
+        inst->owner.c_str(),
+        "org.freedesktop.DBus.Properties",
+        "PropertiesChanged",
+        provision::gatt::CHR_STATE,
+        nullptr,
+        G_DBUS_SIGNAL_FLAGS_NONE,
+        on_state_changed,
+        nullptr,
+        nullptr
+    );
+
+    g_dbus_connection_call(
+        g_bus,
+        inst->owner.c_str(),
+        provision::gatt::CHR_STATE,
+        "org.bluez.GattCharacteristic1",
+        "StartNotify",
+        nullptr,
+        nullptr,
+        G_DBUS_CALL_FLAGS_NONE,
+        -1,
+        nullptr,
+        on_notify_started,
+        GINT_TO_POINTER(inst->index)
+    );
+}
+
+// -----------------------------------------------------------------------------
+// Fake BlueZ
+// -----------------------------------------------------------------------------
+
+const char* XML_ROOT = R"XML(
+<node>
+  <interface name="org.freedesktop.DBus.ObjectManager">
+    <method name="GetManagedObjects">
+      <arg name="objects" type="a{oa{sa{sv}}}" direction="out"/>
+    </method>
+  </interface>
+</node>
+)XML";
+
+const char* XML_BLUEZ = R"XML(
+<node>
+  <interface name="org.bluez.AgentManager1">
+    <method name="RegisterAgent">
+      <arg name="agent" type="o" direction="in"/>
+      <arg name="capability" type="s" direction="in"/>
+    </method>
+    <method name="UnregisterAgent">
+      <arg name="agent" type="o" direction="in"/>
+    </method>
+    <method name="RequestDefaultAgent">
+      <arg name="agent" type="o" direction="in"/>
+    </method>
+  </interface>
+</node>
+)XML";
+
+const char* XML_ADAPTER = R"XML(
+<node>
+  <interface name="org.bluez.Adapter1">
+    <method name="RemoveDevice">
+      <arg name="device" type="o" direction="in"/>
+    </method>
+    <property name="Address" type="s" access="read"/>
+    <property name="Alias" type="s" access="readwrite"/>
+    <property name="Powered" type="b" access="readwrite"/>
+    <property name="Discoverable" type="b" access="readwrite"/>
+    <property name="DiscoverableTimeout" type="u" access="readwrite"/>
+    <property name="Pairable" type="b" access="readwrite"/>
+  </interface>
+  <interface name="org.bluez.GattManager1">
+    <method name="RegisterApplication">
+      <arg name="application" type="o" direction="in"/>
+      <arg name="options" type="a{sv}" direction="in"/>
+    </method>
+    <method name="UnregisterApplication">
+      <arg name="application" type="o" direction="in"/>
+    </method>
+  </interface>
+  <interface name="org.bluez.LEAdvertisingManager1">
+    <method name="RegisterAdvertisement">
+      <arg name="advertisement" type="o" direction="in"/>
+      <arg name="options" type="a{sv}" direction="in"/>
+    </method>
+    <method name="UnregisterAdvertisement">
+      <arg name="service" type="o" direction="in"/>
+    </method>
+  </interface>
+</node>
+)XML";
+
+GVariant* adapter_interfaces()
+{
+    GVariantBuilder ifaces;
+    g_variant_builder_init(&ifaces, G_VARIANT_TYPE("a{sa{sv}}"));
+
+    GVariantBuilder props;
+    g_variant_builder_init(&props, G_VARIANT_TYPE_VARDICT);
+    g_variant_builder_add(&props, "{sv}", "Powered", g_variant_new_boolean(TRUE));
+    g_variant_builder_add(&ifaces, "{s@a{sv}}", "org.bluez.Adapter1",
+                          g_variant_builder_end(&props));
+
+    g_variant_builder_add(&ifaces, "{s@a{sv}}", "org.bluez.GattManager1",
+                          g_variant_new_array(G_VARIANT_TYPE("{sv}"), nullptr, 0));
+    g_variant_builder_add(&ifaces, "{s@a{sv}}", "org.bluez.LEAdvertisingManager1",
+                          g_variant_new_array(G_VARIANT_TYPE("{sv}"), nullptr, 0));
+
+    return g_variant_builder_end(&ifaces);
+}
+
+void on_root_call(GDBusConnection*,
+                  const gchar*,
+                  const gchar*,
+                  const gchar*,
+                  const gchar*,
+                  GVariant*,
+                  GDBusMethodInvocation* invocation,
+                  gpointer)
+{
+    GVariantBuilder objects;
+    g_variant_builder_init(&objects, G_VARIANT_TYPE("a{oa{sa{sv}}}"));
+
+    for (const auto& inst : g_inst) {
+        g_variant_builder_add(&objects, "{o@a{sa{sv}}}",
+                              inst.adapter_path.c_str(), adapter_interfaces());
+    }
+
+    g_dbus_method_invocation_return_value(
+        invocation, g_variant_new("(@a{oa{sa{sv}}})", g_variant_builder_end(&objects)));
+}
+
+void on_bluez_call(GDBusConnection*,
+                   const gchar*,
+                   const gchar*,
+                   const gchar*,
+                   const gchar*,
+                   GVariant*,
+                   GDBusMethodInvocation* invocation,
+                   gpointer)
+{
+    // AgentManager1: accept everything.
+    g_dbus_method_invocation_return_value(invocation, nullptr);
+}
+
+void on_adapter_call(GDBusConnection*,
+                     const gchar* sender,
+                     const gchar* object_path,
+                     const gchar*,
+                     const gchar* method,
+                     GVariant* parameters,
+                     GDBusMethodInvocation* invocation,
+                     gpointer)
+{
+    Instance* inst = by_adapter(object_path);
+    const std::string m(method);
+
+    g_dbus_method_invocation_return_value(invocation, nullptr);
+
+    if (!inst)
+        return;
+
+    if (m == "RegisterApplication") {
+        const char* app = nullptr;
+        g_variant_get(parameters, "(&o@a{sv})", &app, nullptr);
+
+        inst->owner = sender;
+        inst->t_app = g_get_monotonic_time();
+
+        // Like bluetoothd: read the application's object tree.
+        g_dbus_connection_call(
+            g_bus,
+            sender,
+            app,
+            "org.freedesktop.DBus.ObjectManager",
+            "GetManagedObjects",
+            nullptr,
+            G_VARIANT_TYPE("(a{oa{sa{sv}}})"),
+            G_DBUS_CALL_FLAGS_NONE,
+            -1,
+            nullptr,
+            on_app_objects,
+            GINT_TO_POINTER(inst->index)
+        );
+    } else if (m == "RegisterAdvertisement") {
+        inst->t_adv = g_get_monotonic_time();
+    }
+}
+
+GVariant* on_adapter_get(GDBusConnection*,
+                         const gchar*,
+                         const gchar* object_path,
+                         const gchar*,
+                         const gchar* prop,
+                         GError**,
+                         gpointer)
+{
+    const std::string p(prop);
+    Instance* inst = by_adapter(object_path);
+
+    if (p == "Address") {
+        char addr[18];
+        std::snprintf(addr, sizeof(addr), "02:00:00:00:%02X:%02X",
+                      inst ? (inst->index >> 8) & 0xff : 0,
+                      inst ? inst->index & 0xff : 0);
+        return g_variant_new_string(addr);
+    }
+    if (p == "Alias")
+        return g_variant_new_string(inst ? inst->alias.c_str() : "");
+    if (p == "DiscoverableTimeout")
+        return g_variant_new_uint32(0);
+
+    return g_variant_new_boolean(TRUE);
+}
+
+gboolean on_adapter_set(GDBusConnection*,
+                        const gchar*,
+                        const gchar* object_path,
+                        const gchar*,
+                        const gchar* prop,
+                        GVariant* value,
+                        GError**,
+                        gpointer)
+{
+    Instance* inst = by_adapter(object_path);
+    if (inst && std::strcmp(prop, "Alias") == 0)
+        inst->alias = g_variant_get_string(value, nullptr);
+    return TRUE;
+}
+
+const GDBusInterfaceVTable ROOT_VTABLE = {on_root_call, nullptr, nullptr, {0}};
+const GDBusInterfaceVTable BLUEZ_VTABLE = {on_bluez_call, nullptr, nullptr, {0}};
+const GDBusInterfaceVTable ADAPTER_VTABLE = {on_adapter_call, on_adapter_get, on_adapter_set, {0}};
+
+bool export_fake_bluez()
+{
+    GError* err = nullptr;
+
+    GDBusNodeInfo* root = g_dbus_node_info_new_for_xml(XML_ROOT, &err);
+    GDBusNodeInfo* bluez = root ? g_dbus_node_info_new_for_xml(XML_BLUEZ, &err) : nullptr;
+    GDBusNodeInfo* adapter = bluez ? g_dbus_node_info_new_for_xml(XML_ADAPTER, &err) : nullptr;
+
+    bool ok = adapter != nullptr;
+
+    if (ok) {
+        ok = g_dbus_connection_register_object(g_bus, "/", root->interfaces[0],
+                                               &ROOT_VTABLE, nullptr, nullptr, &err) &&
+             g_dbus_connection_register_object(g_bus, "/org/bluez", bluez->interfaces[0],
+                                               &BLUEZ_VTABLE, nullptr, nullptr, &err);
+    }
+
+    for (size_t i = 0; ok && i < g_inst.size(); ++i) {
+        for (int k = 0; ok && adapter->interfaces[k]; ++k) {
+            ok = g_dbus_connection_register_object(
+                     g_bus, g_inst[i].adapter_path.c_str(), adapter->interfaces[k],
+                     &ADAPTER_VTABLE, nullptr, nullptr, &err) != 0;
+        }
+    }
+
+    if (!ok) {
+        std::fprintf(stderr, "provision-fleet: fake BlueZ export failed: %s\n",
+                     err && err->message ? err->message : "unknown error");
+        if (err) g_error_free(err);
+    }
+
+    if (root) g_dbus_node_info_unref(root);
+    if (bluez) g_dbus_node_info_unref(bluez);
+    if (adapter) g_dbus_node_info_unref(adapter);
+    return ok;
+}
+
+GDBusMessage* count_messages(GDBusConnection*, GDBusMessage* message,
+                             gboolean incoming, gpointer)
+{
+    // Runs on the GDBus worker thread.
+    if (incoming)
+        ++g_msgs_in;
+    else
+        ++g_msgs_out;
+    return message;
+}
+
+// -----------------------------------------------------------------------------
+// Daemon instances
+// -----------------------------------------------------------------------------
+
+std::string write_instance_config(const Instance& inst)
+{
+    const std::string dir = g_opt.workdir + "/" + std::to_string(inst.index);
+    g_mkdir_with_parents(dir.c_str(), 0700);
+
+    std::ostringstream conf;
+    conf << "[log]\npath=" << dir << "/ble.log\n"
+         << "[ctl]\nsocket=" << dir << "/ctl.sock\n"
+         << "[drop]\npath=" << dir << "/provision.json\n"
+         << "[adapter]\npath=" << inst.adapter_path << "\n"
+         << "alias=sim-" << inst.index << "\n"
+         << "[wifi]\nbackend=sim\n"
+         << "[sim]\nssids=" << SIM_SSID << ",Neighbour,Cafe\n"
+         << "psk=" << SIM_PSK << "\n"
+         << "connect_ms=" << g_opt.connect_ms << "\n"
+         << "ip=10." << ((inst.index >> 8) & 0xff) << "."
+         << (inst.index & 0xff) << ".2\n"
+         << "[mdns]\nenabled=false\n"
+         << "[watchdog]\nenabled=false\n"
+         << "[agent]\npurge_bonds=false\n";
+
+    const std::string path = dir + "/provision.conf";
+    std::ofstream(path) << conf.str();
+    return path;
+}
+
+void on_child_exit(GPid pid, gint status, gpointer user_data)
+{
+    auto* inst = &g_inst[GPOINTER_TO_INT(user_data)];
+    inst->exited = true;
+
+    if (!inst->t_connected)
+        std::fprintf(stderr, "provision-fleet: #%d (pid %d) exited early, status %d\n",
+                     inst->index, static_cast<int>(pid), status);
+
+    g_spawn_close_pid(pid);
+}
+
+void spawn_instance(Instance& inst, const std::string& bus_address)
+{
+    const std::string conf = write_instance_config(inst);
+
+    gchar** env = g_get_environ();
+    env = g_environ_setenv(env, "DBUS_SYSTEM_BUS_ADDRESS", bus_address.c_str(), TRUE);
+    env = g_environ_setenv(env, "PROVISION_CONFIG", conf.c_str(), TRUE);
+
+    gchar* argv[] = {const_cast<gchar*>(g_opt.daemon.c_str()), nullptr};
+
+    GError* err = nullptr;
+    inst.t_spawn = g_get_monotonic_time();
+    if (!g_spawn_async(nullptr, argv, env, G_SPAWN_DO_NOT_REAP_CHILD,
+                       nullptr, nullptr, &inst.pid, &err)) {
+        std::fprintf(stderr, "provision-fleet: spawn #%d failed: %s\n",
+                     inst.index, err && err->message ? err->message : "unknown error");
+        if (err) g_error_free(err);
+        inst.exited = true;
+    } else {
+        g_child_watch_add(inst.pid, on_child_exit, GINT_TO_POINTER(inst.index));
+    }
+
+    g_strfreev(env);
+}
+
+gboolean on_spawn_tick(gpointer user_data)
+{
+    const auto* address = static_cast<const std::string*>(user_data);
+
+    spawn_instance(g_inst[g_next_spawn], *address);
+    return ++g_next_spawn < g_opt.instances ? G_SOURCE_CONTINUE : G_SOURCE_REMOVE;
+}
+
+gboolean on_timeout(gpointer)
+{
+    std::fprintf(stderr, "provision-fleet: timeout, %d/%d connected\n",
+                 g_done, g_opt.instances);
+    g_main_loop_quit(g_loop);
+    return G_SOURCE_REMOVE;
+}
+
+// -----------------------------------------------------------------------------
+// Report
+// -----------------------------------------------------------------------------
+
+double percentile(std::vector<double> v, double p)
+{
+    if (v.empty())
+        return -1.0;
+    std::sort(v.begin(), v.end());
+    size_t idx = static_cast<size_t>(p * static_cast<double>(v.size() - 1) + 0.5);
+    return v[std::min(idx, v.size() - 1)];
+}
+
+std::string dist_json(const std::vector<double>& v)
+{
+    char buf[160];
+    std::snprintf(buf, sizeof(buf),
+                  "{\"n\":%zu,\"p50\":%.1f,\"p90\":%.1f,\"p99\":%.1f,\"max\":%.1f}",
+                  v.size(), percentile(v, 0.5), percentile(v, 0.9),
+                  percentile(v, 0.99), percentile(v, 1.0));
+    return buf;
+}
+
+/**
+ * Total messages routed by the bus daemon, if it exposes Debug.Stats.
+ */
+long bus_serial()
+{
+    GVariant* reply = g_dbus_connection_call_sync(
+        g_bus, "org.freedesktop.DBus", "/org/freedesktop/DBus",
+        "org.freedesktop.DBus.Debug.Stats", "GetStats",
+        nullptr, G_VARIANT_TYPE("(a{sv})"), G_DBUS_CALL_FLAGS_NONE,
+        1000, nullptr, nullptr);
+    if (!reply)
+        return -1;
+
+    GVariant* stats = g_variant_get_child_value(reply, 0);
+    guint32 serial = 0;
+    bool found = g_variant_lookup(stats, "Serial", "u", &serial);
+    g_variant_unref(stats);
+    g_variant_unref(reply);
+    return found ? static_cast<long>(serial) : -1;
+}
+
+void print_report(gint64 t_end, long serial_start, long serial_end)
+{
+    std::vector<double> to_app, to_registered, to_connected, connect_rtt, rss, hwm, cpu;
+    gint64 last_connected = 0;
+
+    for (auto& inst : g_inst) {
+        if (!inst.t_connected)
+            sample_proc(inst);
+
+        if (inst.t_app)
+            to_app.push_back(ms_since(inst.t_spawn, inst.t_app));
+        if (inst.t_adv)
+            to_registered.push_back(ms_since(inst.t_spawn, inst.t_adv));
+        if (inst.t_connected) {
+            to_connected.push_back(ms_since(inst.t_spawn, inst.t_connected));
+            connect_rtt.push_back(ms_since(inst.t_connect, inst.t_connected));
+            last_connected = std::max(last_connected, inst.t_connected);
+        }
+        if (inst.rss_kb)
+            rss.push_back(static_cast<double>(inst.rss_kb));
+        if (inst.hwm_kb)
+            hwm.push_back(static_cast<double>(inst.hwm_kb));
+        cpu.push_back(inst.cpu_ms);
+    }
+
+    const double wall_s = static_cast<double>((last_connected ? last_connected : t_end) - g_t0) / 1e6;
+    const double rate = wall_s > 0 ? g_done / wall_s : 0.0;
+
+    std::printf("{\n");
+    std::printf("  \"instances\": %d,\n", g_opt.instances);
+    std::printf("  \"connected\": %d,\n", g_done);
+    std::printf("  \"wall_s\": %.3f,\n", wall_s);
+    std::printf("  \"provisioned_per_s\": %.2f,\n", rate);
+    std::printf("  \"spawn_to_gatt_ms\": %s,\n", dist_json(to_app).c_str());
+    std::printf("  \"spawn_to_advertising_ms\": %s,\n", dist_json(to_registered).c_str());
+    std::printf("  \"spawn_to_connected_ms\": %s,\n", dist_json(to_connected).c_str());
+    std::printf("  \"connect_to_connected_ms\": %s,\n", dist_json(connect_rtt).c_str());
+    std::printf("  \"bus\": {\"sim_conn_msgs_in\": %lu, \"sim_conn_msgs_out\": %lu, "
+                "\"routed\": %ld},\n",
+                g_msgs_in.load(), g_msgs_out.load(),
+                (serial_start >= 0 && serial_end >= 0) ? serial_end - serial_start : -1L);
+    std::printf("  \"per_instance\": {\"rss_kb\": %s, \"peak_rss_kb\": %s, \"cpu_ms\": %s}\n",
+                dist_json(rss).c_str(), dist_json(hwm).c_str(), dist_json(cpu).c_str());
+    std::printf("}\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    for (int i = 1; i < argc; ++i) {
+        const bool has_arg = i + 1 < argc;
+        if (std::strcmp(argv[i], "-n") == 0 && has_arg)
+            g_opt.instances = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "-d") == 0 && has_arg)
+            g_opt.daemon = argv[++i];
+        else if (std::strcmp(argv[i], "-w") == 0 && has_arg)
+            g_opt.workdir = argv[++i];
+        else if (std::strcmp(argv[i], "-r") == 0 && has_arg)
+            g_opt.spawn_per_s = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "-c") == 0 && has_arg)
+            g_opt.connect_ms = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "-t") == 0 && has_arg)
+            g_opt.timeout_s = std::atoi(argv[++i]);
+        else {
+            usage();
+            return 2;
+        }
+    }
+
+    if (g_opt.instances <= 0 || g_opt.instances > 4096) {
+        usage();
+        return 2;
+    }
+
+    if (g_opt.workdir.empty()) {
+        gchar* dir = g_dir_make_tmp("provision-fleet-XXXXXX", nullptr);
+        if (!dir) {
+            std::fprintf(stderr, "provision-fleet: cannot create work dir\n");
+            return 1;
+        }
+        g_opt.workdir = dir;
+        g_free(dir);
+    }
+
+    g_inst.resize(static_cast<size_t>(g_opt.instances));
+    for (int i = 0; i < g_opt.instances; ++i) {
+        g_inst[i].index = i;
+        g_inst[i].adapter_path = "/org/bluez/hci" + std::to_string(i);
+    }
+
+    // Private bus (session-style config: no policy restrictions)
+    GTestDBus* test_bus = g_test_dbus_new(G_TEST_DBUS_NONE);
+    g_test_dbus_up(test_bus);
+    const std::string address = g_test_dbus_get_bus_address(test_bus);
+
+    GError* err = nullptr;
+    g_bus = g_dbus_connection_new_for_address_sync(
+        address.c_str(),
+        static_cast<GDBusConnectionFlags>(
+            G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+            G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION),
+        nullptr, nullptr, &err);
+    if (!g_bus) {
+        std::fprintf(stderr, "provision-fleet: cannot connect to private bus: %s\n",
+                     err && err->message ? err->message : "unknown error");
+        if (err) g_error_free(err);
+        g_test_dbus_down(test_bus);
+        g_object_unref(test_bus);
+        return 1;
+    }
+
+    g_dbus_connection_add_filter(g_bus, count_messages, nullptr, nullptr);
+
+    if (!export_fake_bluez()) {
+        g_object_unref(g_bus);
+        g_test_dbus_down(test_bus);
+        g_object_unref(test_bus);
+        return 1;
+    }
+
+    // Objects are in place before the name appears, as with bluetoothd.
+    GVariant* owned = g_dbus_connection_call_sync(
+        g_bus, "org.freedesktop.DBus", "/org/freedesktop/DBus",
+        "org.freedesktop.DBus", "RequestName",
+        g_variant_new("(su)", "org.bluez", 0u),
+        G_VARIANT_TYPE("(u)"), G_DBUS_CALL_FLAGS_NONE, -1, nullptr, nullptr);
+    if (owned) g_variant_unref(owned);
+
+    std::fprintf(stderr, "provision-fleet: %d instance(s), bus %s, work dir %s\n",
+                 g_opt.instances, address.c_str(), g_opt.workdir.c_str());
+
+    g_loop = g_main_loop_new(nullptr, FALSE);
+    const long serial_start = bus_serial();
+    g_t0 = g_get_monotonic_time();
+
+    if (g_opt.spawn_per_s > 0) {
+        const guint interval_ms = static_cast<guint>(1000.0 / g_opt.spawn_per_s);
+        g_timeout_add(std::max(1u, interval_ms), on_spawn_tick,
+                      const_cast<std::string*>(&address));
+    } else {
+        for (auto& inst : g_inst)
+            spawn_instance(inst, address);
+    }
+
+    g_timeout_add_seconds(static_cast<guint>(g_opt.timeout_s), on_timeout, nullptr);
+    g_main_loop_run(g_loop);
+
+    const gint64 t_end = g_get_monotonic_time();
+    const long serial_end = bus_serial();
+    print_report(t_end, serial_start, serial_end);
+
+    for (auto& inst : g_inst) {
+        if (!inst.exited && inst.pid > 0)
+            kill(inst.pid, SIGTERM);
+    }
+
+    g_main_loop_unref(g_loop);
+    g_object_unref(g_bus);
+    g_test_dbus_down(test_bus);
+    g_object_unref(test_bus);
+
+    return g_done == g_opt.instances ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   Implementation of the main-loop blocking-call detector.
+ *
+ * Notes:
+ *   - Only compiled into builds with PROVISION_BLOCKING_DETECTOR
+ *   - Reporting goes through the logger, which is itself probed; a
+ *     thread-local guard keeps the report from probing itself
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+
+#ifdef PROVISION_BLOCKING_DETECTOR
+
+#include "util/blocking_probe.hpp"
+#include "util/config.hpp"
+#include "util/log.hpp"
+
+#include <glib.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+namespace provision::blocking {
+
+static std::thread::id g_main_thread;
+static bool g_initialised = false;
+static gint64 g_threshold_us = 5 * 1000;
+static bool g_strict = false;
+static std::atomic<unsigned> g_violations{0};
+static std::atomic<unsigned> g_known{0};
+
+static thread_local bool t_reporting = false;
+
+static bool strict_from_env()
+{
+    const char* env = std::getenv("PROVISION_BLOCKING_STRICT");
+    return env && std::strcmp(env, "1") == 0;
+}
+
+void init()
+{
+    g_main_thread = std::this_thread::get_id();
+    g_strict = strict_from_env();
+    g_initialised = true;
+}
+
+void configure()
+{
+    g_threshold_us =
+        provision::config::get_int("debug", "blocking_threshold_ms", 5) * 1000;
+    g_strict = strict_from_env() ||
+               provision::config::get_bool("debug", "blocking_strict", false);
+
+    provision::log::info(
+        "blocking detector: threshold_ms=" + std::to_string(g_threshold_us / 1000) +
+        (g_strict ? " strict" : "") +
+        " violations_so_far=" + std::to_string(g_violations.load()) +
+        " known_so_far=" + std::to_string(g_known.load()));
+}
+
+unsigned violation_count()
+{
+    return g_violations.load();
+}
+
+unsigned known_count()
+{
+    return g_known.load();
+}
+
+Scope::Scope(const char* what, const char* file, int line, bool known)
+    : what_(what),
+      file_(file),
+      line_(line),
+      known_(known),
+      start_us_(0),
+      active_(g_initialised && !t_reporting &&
+              std::this_thread::get_id() == g_main_thread)
+{
+    if (active_)
+        start_us_ = g_get_monotonic_time();
+}
+
+Scope::~Scope()
+{
+    if (!active_)
+        return;
+
+    const gint64 elapsed = g_get_monotonic_time() - start_us_;
+    if (elapsed <= g_threshold_us)
+        return;
+
+    const std::string report =
+        std::string(what_) + " at " + file_ + ":" + std::to_string(line_) +
+        " took " + std::to_string(elapsed / 1000) + "ms";
+
+    t_reporting = true;
+    if (known_) {
+        ++g_known;
+        provision::log::info("known blocking call on main loop: " + report);
+        t_reporting = false;
+        return;
+    }
+
+    ++g_violations;
+    provision::log::warn("blocking call on main loop: " + report);
+    t_reporting = false;
+
+    if (g_strict)
+        std::abort();
+}
+
+} // namespace provision::blocking
+
+#endif // PROVISION_BLOCKING_DETECTOR
@@ -0,0 +1,104 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   Debug-build detector for blocking calls on the main-loop thread.
+ *
+ * Notes:
+ *   - Known blocking primitives are wrapped in PROVISION_BLOCKING_CALL(),
+ *     a scope guard that times the enclosing block
+ *   - When built with PROVISION_BLOCKING_DETECTOR and the block ran on the
+ *     main-loop thread for longer than [debug] blocking_threshold_ms, the
+ *     call site and duration are logged and counted as a violation
+ *   - PROVISION_BLOCKING_CALL_KNOWN() marks the baseline: calls we know
+ *     block today (startup config read, sync NMClient init, the scan
+ *     sleep, log writes ...). They are timed and logged the same way but
+ *     counted separately and never fail a run, so a clean tree passes
+ *     and only new blocking calls trip the detector
+ *   - [debug] blocking_strict=true (or PROVISION_BLOCKING_STRICT=1) aborts
+ *     on the first violation so a test harness fails loudly
+ *   - Without PROVISION_BLOCKING_DETECTOR the macro compiles to nothing
+ *
+ * Usage:
+ *   {
+ *       PROVISION_BLOCKING_CALL_KNOWN("g_usleep");
+ *       g_usleep(700 * 1000);
+ *   }
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+#pragma once
+
+#ifdef PROVISION_BLOCKING_DETECTOR
+
+#include <cstdint>
+
+namespace provision::blocking {
+
+/**
+ * Mark the calling thread as the main-loop thread and start probing with
+ * the defaults (and PROVISION_BLOCKING_STRICT). Call first thing in
+ * main(), before config::load(), so the config read is probed too.
+ */
+void init();
+
+/**
+ * Apply [debug] blocking_threshold_ms / blocking_strict.
+ * Call once after config::load().
+ */
+void configure();
+
+/**
+ * Number of violations recorded so far.
+ */
+unsigned violation_count();
+
+/**
+ * Number of slow baseline (PROVISION_BLOCKING_CALL_KNOWN) calls seen so
+ * far; informational, not a failure.
+ */
+unsigned known_count();
+
+class Scope {
+public:
+    Scope(const char* what, const char* file, int line, bool known = false);
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    const char* what_;
+    const char* file_;
+    int line_;
+    bool known_;
+    std::int64_t start_us_;
+    bool active_;
+};
+
+} // namespace provision::blocking
+
+#define PROVISION_BLOCKING_CONCAT_(a, b) a##b
+#define PROVISION_BLOCKING_CONCAT(a, b) PROVISION_BLOCKING_CONCAT_(a, b)
+#define PROVISION_BLOCKING_CALL(what) \
+    ::provision::blocking::Scope PROVISION_BLOCKING_CONCAT(blocking_scope_, __LINE__)( \
+        (what), __FILE__, __LINE__)
+#define PROVISION_BLOCKING_CALL_KNOWN(what) \
+    ::provision::blocking::Scope PROVISION_BLOCKING_CONCAT(blocking_scope_, __LINE__)( \
+        (what), __FILE__, __LINE__, true)
+
+#else
+
+#define PROVISION_BLOCKING_CALL(what) static_cast<void>(0)
+#define PROVISION_BLOCKING_CALL_KNOWN(what) static_cast<void>(0)
+
+#endif
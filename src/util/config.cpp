@@ -0,0 +1,122 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   BLE-based provisioning daemon for Raspberry Pi devices.
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+
+// File: src/util/config.cpp
+// Purpose:
+//   GKeyFile-backed implementation of provision::config.
+//
+// Failure handling:
+//   - A missing file is normal (all defaults); a malformed one is logged
+//     and ignored.
+//   - Getters never throw.
+
+#include "util/config.hpp"
+#include "util/log.hpp"
+#include "util/blocking_probe.hpp"
+
+#include <glib.h>
+
+#include <cstdlib>
+
+namespace provision::config {
+
+static GKeyFile* g_keyfile = nullptr;
+
+void load(const std::string& path)
+{
+    std::string file = path;
+    if (file.empty()) {
+        const char* env = std::getenv("PROVISION_CONFIG");
+        file = (env && *env) ? env : DEFAULT_CONFIG_PATH;
+    }
+
+    if (g_keyfile)
+        g_key_file_unref(g_keyfile);
+    g_keyfile = g_key_file_new();
+
+    GError* err = nullptr;
+    PROVISION_BLOCKING_CALL_KNOWN("config file read");
+    if (!g_key_file_load_from_file(g_keyfile, file.c_str(), G_KEY_FILE_NONE, &err)) {
+        if (err && !g_error_matches(err, G_FILE_ERROR, G_FILE_ERROR_NOENT)) {
+            provision::log::warn("config: ignoring " + file + ": " + err->message);
+        } else {
+            provision::log::info("config: " + file + " not found, using defaults");
+        }
+        if (err) g_error_free(err);
+        return;
+    }
+
+    provision::log::info("config: loaded " + file);
+}
+
+std::string get_string(const char* group, const char* key, const std::string& fallback)
+{
+    if (!g_keyfile)
+        return fallback;
+
+    gchar* v = g_key_file_get_string(g_keyfile, group, key, nullptr);
+    if (!v)
+        return fallback;
+
+    std::string out(v);
+    g_free(v);
+    return out;
+}
+
+long get_int(const char* group, const char* key, long fallback)
+{
+    if (!g_keyfile)
+        return fallback;
+
+    GError* err = nullptr;
+    gint64 v = g_key_file_get_int64(g_keyfile, group, key, &err);
+    if (err) {
+        g_error_free(err);
+        return fallback;
+    }
+    return static_cast<long>(v);
+}
+
+bool get_bool(const char* group, const char* key, bool fallback)
+{
+    if (!g_keyfile)
+        return fallback;
+
+    GError* err = nullptr;
+    gboolean v = g_key_file_get_boolean(g_keyfile, group, key, &err);
+    if (err) {
+        g_error_free(err);
+        return fallback;
+    }
+    return v != FALSE;
+}
+
+std::vector<std::string> groups()
+{
+    std::vector<std::string> out;
+    if (!g_keyfile)
+        return out;
+
+    gchar** names = g_key_file_get_groups(g_keyfile, nullptr);
+    for (gchar** n = names; n && *n; ++n)
+        out.emplace_back(*n);
+    g_strfreev(names);
+    return out;
+}
+
+} // namespace provision::config
@@ -0,0 +1,52 @@
+// File: src/util/config.hpp
+// Purpose:
+//   Small key/value configuration for the provision-ble daemon.
+//
+// Design:
+//   - INI-style file parsed once at startup with GKeyFile.
+//   - Every key has a compiled-in default; a missing file or key is fine.
+//   - Default path /etc/provision/provision.conf, overridable with the
+//     PROVISION_CONFIG environment variable.
+//
+// Example:
+//   [agent]
+//   mode=just-works
+/*
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace provision::config {
+
+inline constexpr const char* DEFAULT_CONFIG_PATH = "/etc/provision/provision.conf";
+
+/// Load configuration from path (or $PROVISION_CONFIG if path is empty).
+/// Call once at startup, before any getter.
+void load(const std::string& path = {});
+
+/// String value, or fallback if unset.
+std::string get_string(const char* group, const char* key, const std::string& fallback);
+
+/// Integer value, or fallback if unset or malformed.
+long get_int(const char* group, const char* key, long fallback);
+
+/// Boolean value (true/false), or fallback if unset or malformed.
+bool get_bool(const char* group, const char* key, bool fallback);
+
+/// Group names in file order (empty if no file was loaded).
+std::vector<std::string> groups();
+
+} // namespace provision::config
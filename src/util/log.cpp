@@ -57,7 +57,10 @@
  */
 
 #include "util/log.hpp"
+#include "util/blocking_probe.hpp"
+#include "util/trace.hpp"
 
+#include <chrono>
 #include <ctime>
 #include <fstream>
 #include <mutex>
@@ -73,6 +76,15 @@ static void write_line(const char* level, const std::string& message)
         return;
     }
 
+    // Declared before the lock so a violation report runs after unlock.
+    PROVISION_BLOCKING_CALL_KNOWN("log file write");
+
+    // Timed only while a tracer is attached (the logger has no GLib).
+    std::chrono::steady_clock::time_point start{};
+    const bool traced = PROVISION_TRACE_ENABLED(log_write);
+    if (traced)
+        start = std::chrono::steady_clock::now();
+
     std::lock_guard<std::mutex> lock(g_mutex);
 
     std::ofstream file(g_log_path, std::ios::app);
@@ -85,6 +97,13 @@ static void write_line(const char* level, const std::string& message)
     std::strftime(ts, sizeof(ts), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
 
     file << ts << " [" << level << "] " << message << "\n";
+
+    if (traced) {
+        file.flush();
+        const auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        PROVISION_TRACE3(log_write, level, message.size(), static_cast<long>(us));
+    }
 }
 
 void init(const std::string& logfile_path)
@@ -29,6 +29,9 @@
 
 namespace provision::log {
 
+/// Default log file ([log] path overrides it).
+inline constexpr const char* DEFAULT_LOG_PATH = "/var/log/provision/ble.log";
+
 /// Initialise logging.
 /// Must be called once at startup before any log calls.
 void init(const std::string& logfile_path);
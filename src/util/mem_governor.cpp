@@ -0,0 +1,229 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   Implementation of the memory budget governor.
+ *
+ * Notes:
+ *   - PSI trigger: "some <stall_us> <window_us>" written to an O_RDWR fd
+ *     of /proc/pressure/memory; the kernel then raises POLLPRI each time
+ *     the stall threshold is crossed within a window
+ *   - No PSI (older kernel, CONFIG_PSI=n) just means a fixed budget
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+
+#include "util/mem_governor.hpp"
+#include "util/config.hpp"
+#include "util/log.hpp"
+
+#include <glib.h>
+#include <glib-unix.h>
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr const char* PSI_MEMORY_PATH = "/proc/pressure/memory";
+
+// Evict down to this share of the limit so the next insert does not
+// immediately trigger another round.
+constexpr size_t LOW_WATERMARK_PCT = 90;
+
+struct Consumer {
+    const char* name;
+    provision::mem::Tier tier;
+    provision::mem::EvictCallback evict;
+    size_t bytes;
+};
+
+static std::vector<Consumer> g_consumers;
+static size_t g_total = 0;
+
+static size_t g_budget = 0;             // 0: not started / unlimited
+static size_t g_pressure_pct = 50;
+static guint g_pressure_hold_s = 30;
+
+static bool g_under_pressure = false;
+static guint g_relax_source = 0;
+static bool g_enforcing = false;
+static bool g_warned_pinned = false;
+
+size_t current_limit()
+{
+    return g_under_pressure ? g_budget * g_pressure_pct / 100 : g_budget;
+}
+
+void enforce()
+{
+    const size_t limit = current_limit();
+    if (limit == 0 || g_total <= limit || g_enforcing)
+        return;
+
+    // Eviction callbacks report back through set_usage(); do not recurse.
+    g_enforcing = true;
+
+    const size_t target = limit * LOW_WATERMARK_PCT / 100;
+    const size_t before = g_total;
+
+    for (int tier = static_cast<int>(provision::mem::Tier::REPLAY);
+         tier <= static_cast<int>(provision::mem::Tier::NOTIFY_QUEUE) && g_total > target;
+         ++tier) {
+        for (size_t i = 0; i < g_consumers.size() && g_total > target; ++i) {
+            Consumer& c = g_consumers[i];
+            if (static_cast<int>(c.tier) != tier || !c.evict || c.bytes == 0)
+                continue;
+
+            const size_t freed = c.evict(g_total - target);
+            if (freed > 0)
+                provision::log::info(std::string("memory: evicted ") +
+                                     std::to_string(freed) + " bytes from " + c.name);
+        }
+    }
+
+    g_enforcing = false;
+
+    if (g_total > limit) {
+        if (!g_warned_pinned) {
+            provision::log::warn("memory: " + std::to_string(g_total) +
+                                 " bytes still in use after eviction (limit " +
+                                 std::to_string(limit) + ")");
+            g_warned_pinned = true;
+        }
+    } else {
+        g_warned_pinned = false;
+    }
+
+    if (g_total != before)
+        provision::log::info("memory: " + std::to_string(before) + " -> " +
+                             std::to_string(g_total) + " bytes (limit " +
+                             std::to_string(limit) + ")");
+}
+
+gboolean on_pressure_relaxed(gpointer)
+{
+    g_relax_source = 0;
+    g_under_pressure = false;
+    provision::log::info("memory: pressure subsided, budget restored");
+    return G_SOURCE_REMOVE;
+}
+
+gboolean on_pressure(gint, GIOCondition condition, gpointer)
+{
+    if (condition & (G_IO_ERR | G_IO_HUP | G_IO_NVAL)) {
+        provision::log::warn("memory: PSI trigger closed by the kernel");
+        return G_SOURCE_REMOVE;
+    }
+
+    if (!g_under_pressure) {
+        g_under_pressure = true;
+        provision::log::warn("memory: system memory pressure, budget cut to " +
+                             std::to_string(g_pressure_pct) + "%");
+    }
+
+    // Restore only after a quiet period; every event restarts it.
+    if (g_relax_source)
+        g_source_remove(g_relax_source);
+    g_relax_source = g_timeout_add_seconds(g_pressure_hold_s, on_pressure_relaxed, nullptr);
+
+    enforce();
+    return G_SOURCE_CONTINUE;
+}
+
+void arm_psi_trigger()
+{
+    const long stall_ms = provision::config::get_int("memory", "pressure_stall_ms", 150);
+    const long window_ms = provision::config::get_int("memory", "pressure_window_ms", 2000);
+
+    int fd = open(PSI_MEMORY_PATH, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        provision::log::info(std::string("memory: no PSI (") + std::strerror(errno) +
+                             "), fixed budget only");
+        return;
+    }
+
+    const std::string trigger = "some " + std::to_string(stall_ms * 1000) + " " +
+                                std::to_string(window_ms * 1000);
+
+    // The trigger string must include the terminating NUL.
+    if (write(fd, trigger.c_str(), trigger.size() + 1) < 0) {
+        provision::log::warn("memory: PSI trigger \"" + trigger + "\" rejected: " +
+                             std::strerror(errno));
+        close(fd);
+        return;
+    }
+
+    // The fd stays open for the life of the daemon; closing it drops the trigger.
+    g_unix_fd_add(fd, static_cast<GIOCondition>(G_IO_PRI | G_IO_ERR), on_pressure, nullptr);
+
+    provision::log::info("memory: PSI trigger armed (" + trigger + ")");
+}
+
+} // namespace
+
+namespace provision::mem {
+
+ConsumerId register_consumer(const char* name, Tier tier, EvictCallback evict)
+{
+    g_consumers.push_back(Consumer{name, tier, std::move(evict), 0});
+    return static_cast<ConsumerId>(g_consumers.size() - 1);
+}
+
+void set_usage(ConsumerId id, size_t bytes)
+{
+    if (id < 0 || static_cast<size_t>(id) >= g_consumers.size())
+        return;
+
+    Consumer& c = g_consumers[static_cast<size_t>(id)];
+    g_total = g_total - c.bytes + bytes;
+    c.bytes = bytes;
+
+    enforce();
+}
+
+size_t total_usage()
+{
+    return g_total;
+}
+
+void start_memory_governor()
+{
+    const long budget_kb = provision::config::get_int("memory", "budget_kb", 1024);
+    if (budget_kb <= 0) {
+        provision::log::info("memory: no budget ([memory] budget_kb=0)");
+        return;
+    }
+
+    g_budget = static_cast<size_t>(budget_kb) * 1024;
+
+    const long pct = provision::config::get_int("memory", "pressure_pct", 50);
+    g_pressure_pct = pct > 0 && pct <= 100 ? static_cast<size_t>(pct) : 50;
+
+    const long hold = provision::config::get_int("memory", "pressure_hold_s", 30);
+    g_pressure_hold_s = hold > 0 ? static_cast<guint>(hold) : 30;
+
+    provision::log::info("memory: budget " + std::to_string(budget_kb) + " KiB");
+
+    if (provision::config::get_bool("memory", "psi", true))
+        arm_psi_trigger();
+
+    // Anything recorded before start counts now.
+    enforce();
+}
+
+} // namespace provision::mem
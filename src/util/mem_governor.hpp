@@ -0,0 +1,72 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   Global memory budget for the daemon's caches and buffers.
+ *
+ * Notes:
+ *   - Subsystems register once, then report their current footprint with
+ *     set_usage(); the governor keeps the total
+ *   - Over [memory] budget_kb, consumers are asked to evict in Tier order
+ *     until the total is back under the low watermark (90% of budget)
+ *   - A consumer registered without an eviction callback is accounted but
+ *     never evicted (data still owed to a client)
+ *   - Memory pressure (PSI trigger on /proc/pressure/memory) shrinks the
+ *     budget to [memory] pressure_pct until pressure has been quiet for
+ *     [memory] pressure_hold_s
+ *   - Main context only; eviction runs synchronously inside set_usage()
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace provision::mem {
+
+/// Eviction order: earlier tiers are evicted first.
+enum class Tier {
+    REPLAY,         // session replay buffers (client can rescan / re-ask)
+    SCAN_CACHE,     // per-SSID scan records (accounted only: security selection)
+    NOTIFY_QUEUE    // queued notifications (accounted only)
+};
+
+/**
+ * Free at least `wanted` bytes if possible and report the new footprint
+ * through set_usage(). Returns the number of bytes freed.
+ */
+using EvictCallback = std::function<size_t(size_t wanted)>;
+
+using ConsumerId = int;
+
+/**
+ * Register a consumer. evict may be empty for accounted-only memory.
+ * Usable before start_memory_governor(); nothing is enforced until then.
+ */
+ConsumerId register_consumer(const char* name, Tier tier, EvictCallback evict);
+
+/**
+ * Report a consumer's current footprint in bytes. Evicts if the total is
+ * now over budget.
+ */
+void set_usage(ConsumerId id, size_t bytes);
+
+/// Sum of all reported footprints.
+size_t total_usage();
+
+/**
+ * Read [memory] and arm the PSI trigger. Call once after config::load().
+ */
+void start_memory_governor();
+
+} // namespace provision::mem
@@ -0,0 +1,175 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   Static metric storage and OpenMetrics text rendering.
+ *
+ * Notes:
+ *   - RSS is read from /proc/self/statm at render time into a stack buffer
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+
+#include "util/metrics.hpp"
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace provision::metrics {
+
+namespace {
+
+struct CounterDef {
+    const char* name;
+    const char* help;
+};
+
+constexpr CounterDef COUNTERS[] = {
+    {"provision_notify_emitted", "GATT notifications emitted"},
+    {"provision_notify_dropped", "Queued GATT notifications dropped on StopNotify"},
+    {"provision_commands", "Commands dispatched (BLE and local)"},
+    {"provision_connect_attempts", "Wi-Fi connect requests"},
+    {"provision_connect_success", "Wi-Fi connects that reached CONNECTED"},
+};
+
+static_assert(sizeof(COUNTERS) / sizeof(COUNTERS[0]) ==
+              static_cast<size_t>(Counter::COUNT), "counter table");
+
+constexpr size_t MAX_BUCKETS = 12;
+
+struct HistogramDef {
+    const char* name;
+    const char* help;
+    double bounds[MAX_BUCKETS];
+    size_t bucket_count;
+};
+
+constexpr HistogramDef HISTOGRAMS[] = {
+    {"provision_provision_seconds", "Time from wifi_connect to CONNECTED",
+     {1, 2, 5, 10, 15, 20, 30, 45, 60, 90, 120}, 11},
+    {"provision_scan_seconds", "Wi-Fi scan duration",
+     {0.1, 0.25, 0.5, 0.75, 1, 1.5, 2, 3, 5, 10}, 10},
+    {"provision_loop_lag_seconds", "Main-loop timer dispatch lateness",
+     {0.001, 0.002, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1}, 10},
+};
+
+static_assert(sizeof(HISTOGRAMS) / sizeof(HISTOGRAMS[0]) ==
+              static_cast<size_t>(Histogram::COUNT), "histogram table");
+
+struct HistogramData {
+    std::uint64_t buckets[MAX_BUCKETS]{};   // non-cumulative
+    std::uint64_t count{0};
+    double sum{0};
+};
+
+static std::atomic<std::uint64_t> g_counters[static_cast<size_t>(Counter::COUNT)];
+static HistogramData g_histograms[static_cast<size_t>(Histogram::COUNT)];
+
+void append_line(std::string& out, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+void append_line(std::string& out, const char* fmt, ...)
+{
+    char line[256];
+
+    va_list ap;
+    va_start(ap, fmt);
+    int n = std::vsnprintf(line, sizeof(line), fmt, ap);
+    va_end(ap);
+
+    if (n > 0)
+        out.append(line, static_cast<size_t>(n) < sizeof(line) ? static_cast<size_t>(n)
+                                                               : sizeof(line) - 1);
+}
+
+long resident_bytes()
+{
+    int fd = open("/proc/self/statm", O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+
+    char buf[128];
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0)
+        return -1;
+    buf[n] = '\0';
+
+    long size = 0, resident = 0;
+    if (std::sscanf(buf, "%ld %ld", &size, &resident) != 2)
+        return -1;
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+} // namespace
+
+void inc(Counter c, std::uint64_t n)
+{
+    g_counters[static_cast<size_t>(c)].fetch_add(n, std::memory_order_relaxed);
+}
+
+void observe(Histogram h, double seconds)
+{
+    const auto idx = static_cast<size_t>(h);
+    const HistogramDef& def = HISTOGRAMS[idx];
+    HistogramData& data = g_histograms[idx];
+
+    for (size_t i = 0; i < def.bucket_count; ++i) {
+        if (seconds <= def.bounds[i]) {
+            ++data.buckets[i];
+            break;
+        }
+    }
+    ++data.count;
+    data.sum += seconds;
+}
+
+void render(std::string& out)
+{
+    for (size_t i = 0; i < static_cast<size_t>(Counter::COUNT); ++i) {
+        const CounterDef& def = COUNTERS[i];
+        append_line(out, "# TYPE %s counter\n# HELP %s %s\n%s_total %llu\n",
+                    def.name, def.name, def.help, def.name,
+                    static_cast<unsigned long long>(
+                        g_counters[i].load(std::memory_order_relaxed)));
+    }
+
+    for (size_t i = 0; i < static_cast<size_t>(Histogram::COUNT); ++i) {
+        const HistogramDef& def = HISTOGRAMS[i];
+        const HistogramData& data = g_histograms[i];
+
+        append_line(out, "# TYPE %s histogram\n# HELP %s %s\n",
+                    def.name, def.name, def.help);
+
+        std::uint64_t cumulative = 0;
+        for (size_t b = 0; b < def.bucket_count; ++b) {
+            cumulative += data.buckets[b];
+            append_line(out, "%s_bucket{le=\"%g\"} %llu\n", def.name, def.bounds[b],
+                        static_cast<unsigned long long>(cumulative));
+        }
+        append_line(out, "%s_bucket{le=\"+Inf\"} %llu\n%s_sum %.6f\n%s_count %llu\n",
+                    def.name, static_cast<unsigned long long>(data.count),
+                    def.name, data.sum,
+                    def.name, static_cast<unsigned long long>(data.count));
+    }
+
+    append_line(out, "# TYPE provision_resident_memory_bytes gauge\n"
+                     "# HELP provision_resident_memory_bytes Resident set size\n"
+                     "provision_resident_memory_bytes %ld\n", resident_bytes());
+
+    out.append("# EOF\n");
+}
+
+} // namespace provision::metrics
@@ -0,0 +1,57 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   In-process counters and histograms, rendered as OpenMetrics text.
+ *
+ * Notes:
+ *   - Fixed set of metrics (enums below); storage is static, so recording
+ *     and rendering never allocate
+ *   - Counters are atomic (any thread); histograms are main-context only
+ *   - Served by ctl/metrics_server; never sent over BLE
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace provision::metrics {
+
+enum class Counter {
+    NOTIFY_EMITTED,     // notifications put on the bus
+    NOTIFY_DROPPED,     // queued notifications dropped on StopNotify
+    COMMANDS,           // commands dispatched (BLE + local)
+    CONNECT_ATTEMPTS,   // wifi_connect requests
+    CONNECT_SUCCESS,    // CONNECTED published
+    COUNT
+};
+
+enum class Histogram {
+    PROVISION_SECONDS,  // wifi_connect request -> CONNECTED
+    SCAN_SECONDS,       // Wi-Fi scan duration
+    LOOP_LAG_SECONDS,   // main-loop timer lateness
+    COUNT
+};
+
+void inc(Counter c, std::uint64_t n = 1);
+
+void observe(Histogram h, double seconds);
+
+/**
+ * Append the OpenMetrics exposition (ending in "# EOF") to out.
+ * Only grows out if its capacity is too small.
+ */
+void render(std::string& out);
+
+} // namespace provision::metrics
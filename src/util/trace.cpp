@@ -0,0 +1,36 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   USDT probe semaphores.
+ *
+ * Notes:
+ *   - Placed in .probes, where tracers look for them; a tracer bumps the
+ *     count while attached
+ *   - Empty translation unit without PROVISION_USDT
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+
+#include "util/trace.hpp"
+
+#ifdef PROVISION_USDT
+
+#define PROVISION_TRACE_DEFINE_(name)                              \
+    __attribute__((section(".probes")))                            \
+    volatile unsigned short provision_##name##_semaphore = 0;
+
+extern "C" {
+PROVISION_TRACE_PROBES(PROVISION_TRACE_DEFINE_)
+}
+
+#endif
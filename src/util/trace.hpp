@@ -0,0 +1,86 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   USDT static tracepoints (sys/sdt.h) on hot paths.
+ *
+ * Notes:
+ *   - Built in when PROVISION_USDT is defined (CMake option, on by default
+ *     when sys/sdt.h is available); otherwise every macro is a no-op
+ *   - A probe site is a single nop until a tracer attaches
+ *   - Arguments that cost something to compute (durations) are guarded by
+ *     PROVISION_TRACE_ENABLED(name), backed by the probe's semaphore;
+ *     bpftrace sets it on attach, perf probe does not
+ *   - Provider is "provision"; see tools/bpftrace for sample scripts
+ *
+ * Probes:
+ *   char_method_entry(path, method)
+ *   char_method_exit(path, method, duration_us)
+ *   notify_emit(path, bytes, fast_path)
+ *   command_dispatch(op, bytes, source)        source: 0 BLE, 1 local
+ *   scan_start()
+ *   scan_done(ssid_count, duration_us)
+ *   connect_phase(ssid, phase)                 request|activate|failed|ipv4
+ *   connect_done(ssid, duration_us)
+ *   netlink_event(type, ifindex, ifname)
+ *   log_write(level, bytes, duration_us)
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+#pragma once
+
+#ifdef PROVISION_USDT
+
+// Every probe gets a semaphore; must precede the include.
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+#define PROVISION_TRACE_PROBES(X) \
+    X(char_method_entry)          \
+    X(char_method_exit)           \
+    X(notify_emit)                \
+    X(command_dispatch)           \
+    X(scan_start)                 \
+    X(scan_done)                  \
+    X(connect_phase)              \
+    X(connect_done)               \
+    X(netlink_event)              \
+    X(log_write)
+
+// Semaphore symbols are referenced by name from the probe notes, so they
+// need C linkage. Defined in util/trace.cpp.
+#define PROVISION_TRACE_DECLARE_(name) \
+    extern volatile unsigned short provision_##name##_semaphore;
+
+extern "C" {
+PROVISION_TRACE_PROBES(PROVISION_TRACE_DECLARE_)
+}
+
+#define PROVISION_TRACE_ENABLED(name) \
+    __builtin_expect(provision_##name##_semaphore != 0, 0)
+
+#define PROVISION_TRACE0(name)             STAP_PROBE(provision, name)
+#define PROVISION_TRACE1(name, a)          STAP_PROBE1(provision, name, a)
+#define PROVISION_TRACE2(name, a, b)       STAP_PROBE2(provision, name, a, b)
+#define PROVISION_TRACE3(name, a, b, c)    STAP_PROBE3(provision, name, a, b, c)
+
+#else
+
+// Arguments stay unevaluated but count as used.
+#define PROVISION_TRACE_ENABLED(name)      false
+#define PROVISION_TRACE0(name)             static_cast<void>(0)
+#define PROVISION_TRACE1(name, a)          static_cast<void>(sizeof(a))
+#define PROVISION_TRACE2(name, a, b)       static_cast<void>(sizeof(a) + sizeof(b))
+#define PROVISION_TRACE3(name, a, b, c) \
+    static_cast<void>(sizeof(a) + sizeof(b) + sizeof(c))
+
+#endif
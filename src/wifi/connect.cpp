@@ -16,7 +16,11 @@
  * Copyright (c) 2026 PiDevelop
  */
 #include "wifi/connect.hpp"
+#include "wifi/scan.hpp"
+#include "wifi/sim_backend.hpp"
 #include "util/log.hpp"
+#include "util/blocking_probe.hpp"
+#include "util/trace.hpp"
 #include "gatt/state.hpp"
 
 #include <NetworkManager.h>
@@ -30,8 +34,204 @@ namespace {
 
 struct ActivateCtx {
     std::string ssid;
+    guint attempt{0};
+    NMClient* client{nullptr};          // owned; keeps the objects alive
+    NMActiveConnection* active{nullptr}; // owned once AddAndActivate returned
+    gulong state_handler{0};
 };
 
+// Bumped per connect(); only the newest attempt may report a failure (an
+// older one is typically deactivated by the newer activation).
+static guint g_attempt = 0;
+
+void finish_activation(ActivateCtx* ctx, bool ok, const std::string& reason)
+{
+    if (ctx->state_handler)
+        g_signal_handler_disconnect(ctx->active, ctx->state_handler);
+    if (ctx->active)
+        g_object_unref(ctx->active);
+    g_object_unref(ctx->client);
+
+    if (ok) {
+        provision::log::info("wifi_connect: activated ssid=" + ctx->ssid);
+    } else if (ctx->attempt != g_attempt) {
+        provision::log::info("wifi_connect: superseded attempt for " + ctx->ssid +
+                             " ended (" + reason + ")");
+    } else {
+        provision::log::error("wifi_connect: activation failed ssid=" + ctx->ssid +
+                              ": " + reason);
+        provision::gatt::notify_state_connect_failed(ctx->ssid, reason);
+    }
+
+    delete ctx;
+}
+
+/**
+ * Final states only: ACTIVATED (CONNECTED itself is published once IPv4
+ * is up) or DEACTIVATED (wrong key, AP gone, NM timeout ...).
+ */
+void on_active_state(NMActiveConnection*, guint state, guint reason, gpointer user_data)
+{
+    auto* ctx = static_cast<ActivateCtx*>(user_data);
+
+    if (state == NM_ACTIVE_CONNECTION_STATE_ACTIVATED)
+        finish_activation(ctx, true, {});
+    else if (state == NM_ACTIVE_CONNECTION_STATE_DEACTIVATED)
+        finish_activation(ctx, false, "deactivated, reason " + std::to_string(reason));
+}
+
+void on_activate_requested(GObject* source, GAsyncResult* res, gpointer user_data)
+{
+    auto* ctx = static_cast<ActivateCtx*>(user_data);
+
+    GError* err = nullptr;
+    NMActiveConnection* active = nm_client_add_and_activate_connection2_finish(
+        NM_CLIENT(source), res, nullptr, &err);
+
+    if (!active) {
+        std::string msg = err && err->message ? err->message : "unknown error";
+        if (err) g_error_free(err);
+        finish_activation(ctx, false, msg);
+        return;
+    }
+
+    ctx->active = active;
+
+    const NMActiveConnectionState state = nm_active_connection_get_state(active);
+    if (state == NM_ACTIVE_CONNECTION_STATE_ACTIVATED) {
+        finish_activation(ctx, true, {});
+        return;
+    }
+    if (state == NM_ACTIVE_CONNECTION_STATE_DEACTIVATED) {
+        finish_activation(ctx, false, "deactivated");
+        return;
+    }
+
+    ctx->state_handler = g_signal_connect(active, "state-changed",
+                                          G_CALLBACK(on_active_state), ctx);
+}
+
+// -----------------------------------------------------------------------------
+// Security selection
+// -----------------------------------------------------------------------------
+
+enum class Security {
+    OPEN,
+    OWE,          // enhanced open
+    WEP,
+    WPA_PSK,      // WPA/WPA2-Personal
+    TRANSITION,   // WPA2/WPA3-Personal mixed mode
+    SAE,          // WPA3-Personal only
+    ENTERPRISE    // 802.1X, not supported here
+};
+
+const char* security_name(Security sec)
+{
+    switch (sec) {
+    case Security::OPEN:       return "open";
+    case Security::OWE:        return "owe";
+    case Security::WEP:        return "wep";
+    case Security::WPA_PSK:    return "wpa-psk";
+    case Security::TRANSITION: return "wpa2/wpa3-transition";
+    case Security::SAE:        return "sae";
+    case Security::ENTERPRISE: return "802.1x";
+    }
+    return "unknown";
+}
+
+/**
+ * Pick the key management from the AP's advertised flags.
+ */
+Security classify(const provision::wifi::ScanRecord& rec)
+{
+    const guint32 sec = rec.wpa_flags | rec.rsn_flags;
+
+    if (sec & (NM_802_11_AP_SEC_KEY_MGMT_802_1X |
+               NM_802_11_AP_SEC_KEY_MGMT_EAP_SUITE_B_192))
+        return Security::ENTERPRISE;
+
+    const bool sae = sec & NM_802_11_AP_SEC_KEY_MGMT_SAE;
+    const bool psk = sec & NM_802_11_AP_SEC_KEY_MGMT_PSK;
+
+    if (sae && psk)
+        return Security::TRANSITION;
+    if (sae)
+        return Security::SAE;
+    if (psk)
+        return Security::WPA_PSK;
+
+    if (sec & (NM_802_11_AP_SEC_KEY_MGMT_OWE | NM_802_11_AP_SEC_KEY_MGMT_OWE_TM))
+        return Security::OWE;
+
+    if (rec.flags & NM_802_11_AP_FLAGS_PRIVACY)
+        return Security::WEP;
+
+    return Security::OPEN;
+}
+
+/**
+ * Wireless-security setting for sec, or nullptr for open networks.
+ */
+NMSettingWirelessSecurity* make_security_setting(Security sec,
+                                                 const std::string& psk)
+{
+    if (sec == Security::OPEN)
+        return nullptr;
+
+    NMSettingWirelessSecurity* s_sec =
+        NM_SETTING_WIRELESS_SECURITY(nm_setting_wireless_security_new());
+
+    switch (sec) {
+    case Security::OWE:
+        g_object_set(G_OBJECT(s_sec),
+                     NM_SETTING_WIRELESS_SECURITY_KEY_MGMT, "owe",
+                     NM_SETTING_WIRELESS_SECURITY_PMF,
+                     NM_SETTING_WIRELESS_SECURITY_PMF_REQUIRED,
+                     nullptr);
+        break;
+
+    case Security::WEP:
+        g_object_set(G_OBJECT(s_sec),
+                     NM_SETTING_WIRELESS_SECURITY_KEY_MGMT, "none",
+                     NM_SETTING_WIRELESS_SECURITY_WEP_KEY_TYPE,
+                     NM_WEP_KEY_TYPE_PASSPHRASE,
+                     NM_SETTING_WIRELESS_SECURITY_WEP_KEY0, psk.c_str(),
+                     nullptr);
+        break;
+
+    case Security::SAE:
+        // WPA3-only networks mandate PMF.
+        g_object_set(G_OBJECT(s_sec),
+                     NM_SETTING_WIRELESS_SECURITY_KEY_MGMT, "sae",
+                     NM_SETTING_WIRELESS_SECURITY_PSK, psk.c_str(),
+                     NM_SETTING_WIRELESS_SECURITY_PMF,
+                     NM_SETTING_WIRELESS_SECURITY_PMF_REQUIRED,
+                     nullptr);
+        break;
+
+    case Security::TRANSITION:
+        // PSK AKM with optional PMF joins the mixed BSS on the first try
+        // on every supplicant; SAE would fail where it is unsupported.
+        g_object_set(G_OBJECT(s_sec),
+                     NM_SETTING_WIRELESS_SECURITY_KEY_MGMT, "wpa-psk",
+                     NM_SETTING_WIRELESS_SECURITY_PSK, psk.c_str(),
+                     NM_SETTING_WIRELESS_SECURITY_PMF,
+                     NM_SETTING_WIRELESS_SECURITY_PMF_OPTIONAL,
+                     nullptr);
+        break;
+
+    case Security::WPA_PSK:
+    default:
+        g_object_set(G_OBJECT(s_sec),
+                     NM_SETTING_WIRELESS_SECURITY_KEY_MGMT, "wpa-psk",
+                     NM_SETTING_WIRELESS_SECURITY_PSK, psk.c_str(),
+                     nullptr);
+        break;
+    }
+
+    return s_sec;
+}
+
 
 
 
@@ -48,11 +248,18 @@ namespace provision::wifi {
 ConnectResult connect(const std::string& ssid,
                       const std::string& psk)
 {
+    if (sim_backend_enabled())
+        return sim_connect(ssid, psk);
+
     provision::log::info("wifi_connect: starting ssid=" + ssid);
 
     GError* err = nullptr;
 
-    NMClient* client = nm_client_new(nullptr, &err);
+    NMClient* client = nullptr;
+    {
+        PROVISION_BLOCKING_CALL_KNOWN("nm_client_new");
+        client = nm_client_new(nullptr, &err);
+    }
     if (!client) {
         provision::log::error("wifi_connect: NMClient init failed");
         if (err) g_error_free(err);
@@ -80,6 +287,31 @@ ConnectResult connect(const std::string& ssid,
         return ConnectResult::FAILED;
     }
     
+    // ------------------------------------------------------------
+    // Security from the latest scan. Records are never evicted, so a
+    // miss means a hidden SSID or no scan yet: PSK if given, else open.
+    // ------------------------------------------------------------
+
+    Security sec = psk.empty() ? Security::OPEN : Security::WPA_PSK;
+    ScanRecord rec;
+    if (lookup_scan_record(ssid, rec))
+        sec = classify(rec);
+
+    provision::log::info(std::string("wifi_connect: security=") +
+                         security_name(sec) + " ssid=" + ssid);
+
+    if (sec == Security::ENTERPRISE) {
+        provision::log::error("wifi_connect: 802.1X networks are not supported");
+        g_object_unref(client);
+        return ConnectResult::FAILED;
+    }
+
+    if (psk.empty() && sec != Security::OPEN && sec != Security::OWE) {
+        provision::log::error("wifi_connect: network requires a passphrase");
+        g_object_unref(client);
+        return ConnectResult::FAILED;
+    }
+
     // ------------------------------------------------------------
     // Build connection profile
     // ------------------------------------------------------------
@@ -111,15 +343,9 @@ ConnectResult connect(const std::string& ssid,
     g_bytes_unref(ssid_bytes);
     nm_connection_add_setting(connection, NM_SETTING(s_wifi));
 
-    NMSettingWirelessSecurity* s_sec =
-        NM_SETTING_WIRELESS_SECURITY(nm_setting_wireless_security_new());
-
-    g_object_set(G_OBJECT(s_sec),
-                 NM_SETTING_WIRELESS_SECURITY_KEY_MGMT, "wpa-psk",
-                 NM_SETTING_WIRELESS_SECURITY_PSK, psk.c_str(),
-                 nullptr);
-
-    nm_connection_add_setting(connection, NM_SETTING(s_sec));
+    NMSettingWirelessSecurity* s_sec = make_security_setting(sec, psk);
+    if (s_sec)
+        nm_connection_add_setting(connection, NM_SETTING(s_sec));
 
     NMSettingIP4Config* s_ip4 =
         NM_SETTING_IP4_CONFIG(nm_setting_ip4_config_new());
@@ -135,7 +361,12 @@ ConnectResult connect(const std::string& ssid,
     // Activate (async)
     // ------------------------------------------------------------
 
-    auto* ctx = new ActivateCtx{ssid};
+    PROVISION_TRACE2(connect_phase, ssid.c_str(), "activate");
+
+    auto* ctx = new ActivateCtx;
+    ctx->ssid = ssid;
+    ctx->attempt = ++g_attempt;
+    ctx->client = client;   // released in finish_activation()
 
     nm_client_add_and_activate_connection2(
         client,
@@ -144,11 +375,11 @@ ConnectResult connect(const std::string& ssid,
         nullptr,
         nullptr,
         nullptr,
-        nullptr,
+        on_activate_requested,
         ctx
     );
 
-    g_object_unref(client);
+    g_object_unref(connection);
 
     return ConnectResult::REQUESTED;
 }
@@ -0,0 +1,176 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   Implementation of the connectivity watchdog.
+ *
+ * Notes:
+ *   - Four states; the two timed ones give the hysteresis:
+ *       ONLINE    --lost-->  LOSING    --grace expired--> OFFLINE (armed)
+ *       OFFLINE   --up---->  RESTORING --hold expired-->  ONLINE (disarmed)
+ *     A flap back inside either window just cancels the timer
+ *   - Starting offline is ordinary first-time provisioning: armed, but
+ *     State is left alone (no RECOVERY)
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+
+#include "wifi/connectivity_watchdog.hpp"
+#include "dbus/registration.hpp"
+#include "gatt/state.hpp"
+#include "util/config.hpp"
+#include "util/log.hpp"
+
+#include <glib.h>
+
+#include <cstring>
+#include <string>
+
+#include <ifaddrs.h>
+#include <netinet/in.h>
+
+namespace provision::wifi {
+
+namespace {
+
+enum class Link {
+    ONLINE,
+    LOSING,
+    OFFLINE,
+    RESTORING
+};
+
+static bool g_enabled = false;
+static Link g_link = Link::OFFLINE;
+static guint g_timer = 0;
+static guint g_loss_grace_s = 120;
+static guint g_restore_hold_s = 60;
+
+void cancel_timer()
+{
+    if (g_timer) {
+        g_source_remove(g_timer);
+        g_timer = 0;
+    }
+}
+
+gboolean on_grace_expired(gpointer)
+{
+    g_timer = 0;
+    g_link = Link::OFFLINE;
+
+    provision::log::warn("watchdog: no connectivity for " +
+                         std::to_string(g_loss_grace_s) + "s, re-entering provisioning");
+    provision::bluez::set_armed(true);
+    provision::gatt::notify_state_recovery();
+    return G_SOURCE_REMOVE;
+}
+
+gboolean on_hold_expired(gpointer)
+{
+    g_timer = 0;
+    g_link = Link::ONLINE;
+
+    provision::log::info("watchdog: connectivity stable for " +
+                         std::to_string(g_restore_hold_s) + "s, leaving provisioning");
+    provision::bluez::set_armed(false);
+    return G_SOURCE_REMOVE;
+}
+
+/**
+ * True if wlan0 currently has an IPv4 address.
+ */
+bool wlan0_has_ipv4()
+{
+    ifaddrs* list = nullptr;
+    if (getifaddrs(&list) != 0)
+        return false;
+
+    bool found = false;
+    for (ifaddrs* it = list; it; it = it->ifa_next) {
+        if (it->ifa_addr && it->ifa_addr->sa_family == AF_INET &&
+            std::strcmp(it->ifa_name, "wlan0") == 0) {
+            found = true;
+            break;
+        }
+    }
+
+    freeifaddrs(list);
+    return found;
+}
+
+} // namespace
+
+void start_connectivity_watchdog()
+{
+    g_enabled = provision::config::get_bool("watchdog", "enabled", true);
+    if (!g_enabled) {
+        provision::log::info("watchdog: disabled by config");
+        return;
+    }
+
+    g_loss_grace_s = static_cast<guint>(
+        provision::config::get_int("watchdog", "loss_grace_s", 120));
+    g_restore_hold_s = static_cast<guint>(
+        provision::config::get_int("watchdog", "restore_hold_s", 60));
+
+    // Registration starts armed; an already-online device drops out of
+    // provisioning once the hold period confirms the link.
+    g_link = Link::OFFLINE;
+    if (wlan0_has_ipv4())
+        watchdog_link_up();
+}
+
+void watchdog_link_up()
+{
+    if (!g_enabled)
+        return;
+
+    switch (g_link) {
+    case Link::LOSING:
+        cancel_timer();
+        g_link = Link::ONLINE;
+        provision::log::info("watchdog: connectivity back within grace period");
+        break;
+    case Link::OFFLINE:
+        g_link = Link::RESTORING;
+        g_timer = g_timeout_add_seconds(g_restore_hold_s, on_hold_expired, nullptr);
+        break;
+    case Link::ONLINE:
+    case Link::RESTORING:
+        break;
+    }
+}
+
+void watchdog_link_lost()
+{
+    if (!g_enabled)
+        return;
+
+    switch (g_link) {
+    case Link::ONLINE:
+        g_link = Link::LOSING;
+        g_timer = g_timeout_add_seconds(g_loss_grace_s, on_grace_expired, nullptr);
+        provision::log::info("watchdog: connectivity lost, grace " +
+                             std::to_string(g_loss_grace_s) + "s");
+        break;
+    case Link::RESTORING:
+        cancel_timer();
+        g_link = Link::OFFLINE;
+        break;
+    case Link::LOSING:
+    case Link::OFFLINE:
+        break;
+    }
+}
+
+} // namespace provision::wifi
@@ -0,0 +1,47 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   Connectivity watchdog: re-enter provisioning when Wi-Fi stays down.
+ *
+ * Notes:
+ *   - Fed by the wlan0 IPv4 add/remove events (ip_monitor -> dispatcher)
+ *   - Loss must persist for [watchdog] loss_grace_s (default 120) before
+ *     provisioning is re-armed and State becomes RECOVERY
+ *   - Connectivity must then hold for [watchdog] restore_hold_s (default
+ *     60) before advertising and the GATT app are withdrawn again
+ *   - [watchdog] enabled=false keeps the old always-advertising behaviour
+ *   - Main-context only
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+#pragma once
+
+namespace provision::wifi {
+
+/**
+ * Read config and seed the watchdog from the current wlan0 state.
+ * Called from main.cpp once, after start_registration().
+ */
+void start_connectivity_watchdog();
+
+/**
+ * wlan0 has IPv4 (connected).
+ */
+void watchdog_link_up();
+
+/**
+ * wlan0 lost IPv4.
+ */
+void watchdog_link_lost();
+
+} // namespace provision::wifi
@@ -17,6 +17,7 @@
  */
 #include "wifi/ip_monitor.hpp"
 #include "util/log.hpp"
+#include "util/trace.hpp"
 
 #include <thread>
 #include <cstring>
@@ -79,6 +80,8 @@ static void ip_monitor_thread()
             if (!if_indextoname(ifa->ifa_index, ifname))
                 continue;
 
+            PROVISION_TRACE3(netlink_event, nh->nlmsg_type, ifa->ifa_index, ifname);
+
             if (std::strcmp(ifname, "wlan0") != 0)
                 continue;
 
@@ -88,6 +91,7 @@ static void ip_monitor_thread()
                 provision::log::info(
                     "ip_monitor: wlan0 IPv4 removed"
                 );
+                provision::wifi::notify_ipv4_lost();
             }
         }
     }
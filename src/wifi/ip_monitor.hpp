@@ -21,7 +21,8 @@ namespace provision::wifi {
 
 /**
  * Start a background thread that listens for kernel IPv4
- * address changes on wlan0 and logs events.
+ * address changes on wlan0 and forwards them to the Wi-Fi state
+ * dispatcher (CONNECTED, connectivity watchdog).
  *
  * One-shot init, intended to be called from main.cpp.
  */
@@ -0,0 +1,570 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   Implementation of the minimal mDNS responder (RFC 6762 subset).
+ *
+ * Notes:
+ *   - One non-blocking UDP socket on 224.0.0.251:5353 (SO_REUSEADDR so
+ *     it coexists with a system responder), read from the main context
+ *   - Pinned to [mdns] interface (wlan0): the group is joined there,
+ *     IP_MULTICAST_IF is set to the announced address and
+ *     IP_MULTICAST_ALL is off, so with eth0 up nothing goes out (or is
+ *     answered) on the wrong link
+ *   - Only answers questions for the names we own; every answer is the
+ *     full record set, multicast, at most once per second
+ *   - No name compression on output; inbound compression is followed
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+
+#include "wifi/mdns.hpp"
+#include "util/config.hpp"
+#include "util/log.hpp"
+
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+namespace provision::wifi {
+
+namespace {
+
+constexpr const char* MDNS_GROUP = "224.0.0.251";
+constexpr guint16 MDNS_PORT = 5353;
+constexpr const char* DEFAULT_IFACE = "wlan0";
+
+constexpr guint32 TTL_HOST = 120;
+constexpr guint32 TTL_SERVICE = 4500;
+
+constexpr guint16 TYPE_A   = 1;
+constexpr guint16 TYPE_PTR = 12;
+constexpr guint16 TYPE_TXT = 16;
+constexpr guint16 TYPE_SRV = 33;
+constexpr guint16 TYPE_ANY = 255;
+
+constexpr guint16 CLASS_IN = 1;
+constexpr guint16 CLASS_FLUSH = 0x8000; // cache-flush bit for unique records
+
+// Minimum spacing between answers to queries.
+constexpr gint64 REPLY_INTERVAL_US = G_USEC_PER_SEC;
+
+// Announcement delays after the first one (RFC 6762 section 8.3).
+constexpr guint ANNOUNCE_DELAYS_MS[] = {1000, 2000};
+
+struct Records {
+    std::string host;     // single label, e.g. "raspberrypi"
+    std::string service;  // e.g. "_ssh._tcp"
+    guint16 port{22};
+    guint8 ip[4]{};
+};
+
+static GDBusConnection* g_bus = nullptr;   // not owned
+static GSocket* g_sock = nullptr;
+static GSocketAddress* g_dest = nullptr;
+static GSource* g_read_source = nullptr;
+
+static std::string g_iface = DEFAULT_IFACE;
+static Records g_rec;
+static bool g_active = false;
+static size_t g_announce_step = 0;
+static guint g_announce_source = 0;
+static guint g_grace_source = 0;
+static gint64 g_last_reply_us = 0;
+
+// -----------------------------------------------------------------------------
+// Wire format helpers
+// -----------------------------------------------------------------------------
+
+std::string to_lower(std::string s)
+{
+    for (auto& c : s)
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return s;
+}
+
+void put_u16(std::vector<guint8>& b, guint16 v)
+{
+    b.push_back(static_cast<guint8>(v >> 8));
+    b.push_back(static_cast<guint8>(v & 0xff));
+}
+
+void put_u32(std::vector<guint8>& b, guint32 v)
+{
+    put_u16(b, static_cast<guint16>(v >> 16));
+    put_u16(b, static_cast<guint16>(v & 0xffff));
+}
+
+void put_name(std::vector<guint8>& b, const std::string& dotted)
+{
+    size_t start = 0;
+    while (start < dotted.size()) {
+        size_t dot = dotted.find('.', start);
+        if (dot == std::string::npos)
+            dot = dotted.size();
+
+        size_t len = dot - start;
+        if (len > 63)
+            len = 63;
+
+        b.push_back(static_cast<guint8>(len));
+        b.insert(b.end(), dotted.begin() + start, dotted.begin() + start + len);
+        start = dot + 1;
+    }
+    b.push_back(0);
+}
+
+void put_record(std::vector<guint8>& b,
+                const std::string& name,
+                guint16 type,
+                guint16 cls,
+                guint32 ttl,
+                const std::vector<guint8>& rdata)
+{
+    put_name(b, name);
+    put_u16(b, type);
+    put_u16(b, cls);
+    put_u32(b, ttl);
+    put_u16(b, static_cast<guint16>(rdata.size()));
+    b.insert(b.end(), rdata.begin(), rdata.end());
+}
+
+std::string host_fqdn(const Records& r)     { return r.host + ".local"; }
+std::string service_fqdn(const Records& r)  { return r.service + ".local"; }
+std::string instance_fqdn(const Records& r) { return r.host + "." + service_fqdn(r); }
+
+/**
+ * Full answer set: A, PTR, SRV, TXT. TTL 0 for a goodbye.
+ */
+std::vector<guint8> build_response(const Records& r, bool goodbye)
+{
+    std::vector<guint8> b;
+    b.reserve(256);
+
+    // Header: id 0, QR|AA, 0 questions, 4 answers
+    put_u16(b, 0);
+    put_u16(b, 0x8400);
+    put_u16(b, 0);
+    put_u16(b, 4);
+    put_u16(b, 0);
+    put_u16(b, 0);
+
+    const guint32 ttl_host = goodbye ? 0 : TTL_HOST;
+    const guint32 ttl_service = goodbye ? 0 : TTL_SERVICE;
+
+    put_record(b, host_fqdn(r), TYPE_A, CLASS_IN | CLASS_FLUSH, ttl_host,
+               std::vector<guint8>(r.ip, r.ip + 4));
+
+    std::vector<guint8> ptr;
+    put_name(ptr, instance_fqdn(r));
+    put_record(b, service_fqdn(r), TYPE_PTR, CLASS_IN, ttl_service, ptr);
+
+    std::vector<guint8> srv;
+    put_u16(srv, 0);          // priority
+    put_u16(srv, 0);          // weight
+    put_u16(srv, r.port);
+    put_name(srv, host_fqdn(r));
+    put_record(b, instance_fqdn(r), TYPE_SRV, CLASS_IN | CLASS_FLUSH, ttl_host, srv);
+
+    // Empty TXT is a single zero-length string.
+    put_record(b, instance_fqdn(r), TYPE_TXT, CLASS_IN | CLASS_FLUSH, ttl_service,
+               std::vector<guint8>{0});
+
+    return b;
+}
+
+/**
+ * Read a (possibly compressed) name at off; advances off past it.
+ */
+bool read_name(const guint8* p, size_t len, size_t& off, std::string& out)
+{
+    size_t pos = off;
+    bool jumped = false;
+    int jumps = 0;
+
+    out.clear();
+
+    while (pos < len) {
+        guint8 l = p[pos];
+
+        if (l == 0) {
+            if (!jumped)
+                off = pos + 1;
+            return true;
+        }
+
+        if ((l & 0xc0) == 0xc0) {
+            if (pos + 1 >= len || ++jumps > 16)
+                return false;
+            if (!jumped)
+                off = pos + 2;
+            jumped = true;
+            pos = static_cast<size_t>(((l & 0x3f) << 8) | p[pos + 1]);
+            continue;
+        }
+
+        if (pos + 1 + l > len)
+            return false;
+
+        if (!out.empty())
+            out += '.';
+        out.append(reinterpret_cast<const char*>(p + pos + 1), l);
+        pos += 1 + l;
+    }
+
+    return false;
+}
+
+/**
+ * True if a query packet asks for any name we own.
+ */
+bool query_matches(const guint8* p, size_t len, const Records& r)
+{
+    if (len < 12)
+        return false;
+
+    const guint16 flags = static_cast<guint16>((p[2] << 8) | p[3]);
+    if (flags & 0x8000)
+        return false; // a response, not a query
+
+    const guint16 qdcount = static_cast<guint16>((p[4] << 8) | p[5]);
+
+    const std::string host = to_lower(host_fqdn(r));
+    const std::string svc = to_lower(service_fqdn(r));
+    const std::string inst = to_lower(instance_fqdn(r));
+
+    size_t off = 12;
+    for (guint16 i = 0; i < qdcount; ++i) {
+        std::string name;
+        if (!read_name(p, len, off, name) || off + 4 > len)
+            return false;
+
+        const guint16 qtype = static_cast<guint16>((p[off] << 8) | p[off + 1]);
+        off += 4;
+
+        name = to_lower(name);
+
+        if (name == host && (qtype == TYPE_A || qtype == TYPE_ANY))
+            return true;
+        if (name == svc && (qtype == TYPE_PTR || qtype == TYPE_ANY))
+            return true;
+        if (name == inst &&
+            (qtype == TYPE_SRV || qtype == TYPE_TXT || qtype == TYPE_ANY))
+            return true;
+    }
+
+    return false;
+}
+
+// -----------------------------------------------------------------------------
+// Socket
+// -----------------------------------------------------------------------------
+
+void send_response(bool goodbye)
+{
+    if (!g_sock || !g_dest)
+        return;
+
+    std::vector<guint8> pkt = build_response(g_rec, goodbye);
+
+    GError* err = nullptr;
+    if (g_socket_send_to(g_sock, g_dest,
+                         reinterpret_cast<const gchar*>(pkt.data()), pkt.size(),
+                         nullptr, &err) < 0) {
+        provision::log::warn(std::string("mdns: send failed: ") +
+                             (err ? err->message : "unknown error"));
+        if (err) g_error_free(err);
+    }
+}
+
+gboolean on_readable(GSocket* sock, GIOCondition, gpointer)
+{
+    guint8 buf[1500];
+
+    gssize n = g_socket_receive_from(sock, nullptr,
+                                     reinterpret_cast<gchar*>(buf), sizeof(buf),
+                                     nullptr, nullptr);
+
+    if (n > 0 && g_active &&
+        query_matches(buf, static_cast<size_t>(n), g_rec)) {
+        const gint64 now = g_get_monotonic_time();
+        if (now - g_last_reply_us >= REPLY_INTERVAL_US) {
+            g_last_reply_us = now;
+            send_response(false);
+        }
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
+bool open_socket()
+{
+    if (g_sock)
+        return true;
+
+    GError* err = nullptr;
+    GSocket* sock = g_socket_new(G_SOCKET_FAMILY_IPV4,
+                                 G_SOCKET_TYPE_DATAGRAM,
+                                 G_SOCKET_PROTOCOL_UDP,
+                                 &err);
+    if (!sock) {
+        provision::log::warn(std::string("mdns: socket failed: ") +
+                             (err ? err->message : "unknown error"));
+        if (err) g_error_free(err);
+        return false;
+    }
+
+    GInetAddress* any = g_inet_address_new_any(G_SOCKET_FAMILY_IPV4);
+    GSocketAddress* bind_addr = g_inet_socket_address_new(any, MDNS_PORT);
+    GInetAddress* group = g_inet_address_new_from_string(MDNS_GROUP);
+
+    bool ok = g_socket_bind(sock, bind_addr, TRUE, &err) &&
+              g_socket_join_multicast_group(sock, group, FALSE, g_iface.c_str(), &err);
+
+    g_object_unref(bind_addr);
+    g_object_unref(any);
+
+    if (!ok) {
+        provision::log::warn(std::string("mdns: bind/join failed: ") +
+                             (err ? err->message : "unknown error"));
+        if (err) g_error_free(err);
+        g_object_unref(group);
+        g_object_unref(sock);
+        return false;
+    }
+
+    g_socket_set_blocking(sock, FALSE);
+    g_socket_set_multicast_ttl(sock, 255);
+    g_socket_set_multicast_loopback(sock, TRUE);
+
+    // Only traffic for groups joined on this socket (i.e. on g_iface).
+    int off = 0;
+    if (setsockopt(g_socket_get_fd(sock), IPPROTO_IP, IP_MULTICAST_ALL,
+                   &off, sizeof(off)) != 0)
+        provision::log::warn(std::string("mdns: IP_MULTICAST_ALL: ") + std::strerror(errno));
+
+    g_dest = g_inet_socket_address_new(group, MDNS_PORT);
+    g_object_unref(group);
+
+    g_read_source = g_socket_create_source(sock, G_IO_IN, nullptr);
+    g_source_set_callback(g_read_source,
+                          G_SOURCE_FUNC(on_readable),
+                          nullptr, nullptr);
+    g_source_attach(g_read_source, nullptr);
+
+    g_sock = sock;
+    return true;
+}
+
+void close_socket()
+{
+    if (g_read_source) {
+        g_source_destroy(g_read_source);
+        g_source_unref(g_read_source);
+        g_read_source = nullptr;
+    }
+    if (g_dest) {
+        g_object_unref(g_dest);
+        g_dest = nullptr;
+    }
+    if (g_sock) {
+        g_socket_close(g_sock, nullptr);
+        g_object_unref(g_sock);
+        g_sock = nullptr;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Timers
+// -----------------------------------------------------------------------------
+
+gboolean on_announce(gpointer)
+{
+    g_announce_source = 0;
+    if (!g_active)
+        return G_SOURCE_REMOVE;
+
+    send_response(false);
+
+    if (g_announce_step < G_N_ELEMENTS(ANNOUNCE_DELAYS_MS)) {
+        g_announce_source = g_timeout_add(
+            ANNOUNCE_DELAYS_MS[g_announce_step++], on_announce, nullptr);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+gboolean on_grace_expired(gpointer)
+{
+    g_grace_source = 0;
+    provision::log::info("mdns: grace period over");
+    mdns_stop();
+    return G_SOURCE_REMOVE;
+}
+
+void on_avahi_checked(GObject* source, GAsyncResult* res, gpointer)
+{
+    gboolean owned = FALSE;
+    GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), res, nullptr);
+    if (reply) {
+        g_variant_get(reply, "(b)", &owned);
+        g_variant_unref(reply);
+    }
+
+    // Restarted meanwhile: the socket belongs to the new announcement.
+    if (g_active)
+        return;
+
+    if (owned) {
+        provision::log::info("mdns: handing off to system responder");
+    } else {
+        provision::log::info("mdns: sending goodbye");
+        send_response(true);
+    }
+
+    close_socket();
+}
+
+/**
+ * Send from g_iface: its address is the one we announce.
+ */
+bool pin_outgoing_interface(const guint8 ip[4])
+{
+    in_addr addr{};
+    std::memcpy(&addr.s_addr, ip, 4);
+
+    if (setsockopt(g_socket_get_fd(g_sock), IPPROTO_IP, IP_MULTICAST_IF,
+                   &addr, sizeof(addr)) != 0) {
+        provision::log::warn(std::string("mdns: IP_MULTICAST_IF: ") + std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+std::string local_host_label()
+{
+    std::string host = g_get_host_name();
+    size_t dot = host.find('.');
+    if (dot != std::string::npos)
+        host.resize(dot);
+    return host;
+}
+
+} // namespace
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+void init_mdns(GDBusConnection* system_bus)
+{
+    g_bus = system_bus;
+}
+
+std::string mdns_announce(const std::string& ipv4)
+{
+    if (!provision::config::get_bool("mdns", "enabled", true))
+        return {};
+
+    GInetAddress* addr = g_inet_address_new_from_string(ipv4.c_str());
+    if (!addr || g_inet_address_get_family(addr) != G_SOCKET_FAMILY_IPV4) {
+        if (addr) g_object_unref(addr);
+        provision::log::warn("mdns: not an IPv4 address: " + ipv4);
+        return {};
+    }
+
+    const guint8* bytes = g_inet_address_to_bytes(addr);
+    for (int i = 0; i < 4; ++i)
+        g_rec.ip[i] = bytes[i];
+    g_object_unref(addr);
+
+    g_rec.host = local_host_label();
+    g_rec.service = provision::config::get_string("mdns", "service", "_ssh._tcp");
+    g_rec.port = static_cast<guint16>(provision::config::get_int("mdns", "port", 22));
+
+    // Fixed once the socket is open; the interface only matters for the join.
+    if (!g_sock)
+        g_iface = provision::config::get_string("mdns", "interface", DEFAULT_IFACE);
+
+    if (!open_socket())
+        return {};
+
+    if (!pin_outgoing_interface(g_rec.ip)) {
+        // Pending timers see !g_active and stop on their own.
+        g_active = false;
+        close_socket();
+        return {};
+    }
+
+    g_active = true;
+    g_last_reply_us = 0;
+
+    // (Re)start the announcement sequence and the grace period.
+    if (g_announce_source)
+        g_source_remove(g_announce_source);
+    g_announce_step = 0;
+    g_announce_source = g_idle_add(on_announce, nullptr);
+
+    if (g_grace_source)
+        g_source_remove(g_grace_source);
+    const long grace_s = provision::config::get_int("mdns", "grace_s", 300);
+    g_grace_source = g_timeout_add_seconds(static_cast<guint>(grace_s),
+                                           on_grace_expired, nullptr);
+
+    const std::string name = host_fqdn(g_rec);
+    provision::log::info("mdns: announcing " + name + " -> " + ipv4);
+    return name;
+}
+
+void mdns_stop()
+{
+    if (!g_active)
+        return;
+
+    g_active = false;
+
+    if (g_announce_source) {
+        g_source_remove(g_announce_source);
+        g_announce_source = 0;
+    }
+    if (g_grace_source) {
+        g_source_remove(g_grace_source);
+        g_grace_source = 0;
+    }
+
+    if (!g_bus) {
+        send_response(true);
+        close_socket();
+        return;
+    }
+
+    g_dbus_connection_call(
+        g_bus,
+        "org.freedesktop.DBus",
+        "/org/freedesktop/DBus",
+        "org.freedesktop.DBus",
+        "NameHasOwner",
+        g_variant_new("(s)", "org.freedesktop.Avahi"),
+        G_VARIANT_TYPE("(b)"),
+        G_DBUS_CALL_FLAGS_NONE,
+        -1,
+        nullptr,
+        on_avahi_checked,
+        nullptr
+    );
+}
+
+} // namespace provision::wifi
@@ -0,0 +1,53 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   Minimal built-in mDNS responder used right after CONNECTED.
+ *
+ * Notes:
+ *   - Publishes <hostname>.local (A) and one service record
+ *     (PTR/SRV/TXT, default _ssh._tcp port 22) as soon as wlan0 has IPv4
+ *   - Announces three times (0s, 1s, 3s) and answers matching queries
+ *     during a grace period ([mdns] grace_s), then stops
+ *   - At stop, if a system responder (Avahi) owns its bus name we hand
+ *     off silently; otherwise a goodbye (TTL 0) is sent
+ *   - Config: [mdns] enabled, grace_s, service, port, interface
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+#pragma once
+
+#include <gio/gio.h>
+#include <string>
+
+namespace provision::wifi {
+
+/**
+ * Remember the system bus (used for the Avahi hand-off check).
+ * Called from main.cpp once.
+ */
+void init_mdns(GDBusConnection* system_bus);
+
+/**
+ * Start (or restart) announcing <hostname>.local -> ipv4.
+ *
+ * Main-context only. Returns the announced name, or empty if mDNS is
+ * disabled or the socket could not be opened.
+ */
+std::string mdns_announce(const std::string& ipv4);
+
+/**
+ * Stop responding now (goodbye or hand-off, see above).
+ */
+void mdns_stop();
+
+} // namespace provision::wifi
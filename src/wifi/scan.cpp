@@ -17,7 +17,10 @@
  */
 
 #include "wifi/scan.hpp"
+#include "wifi/sim_backend.hpp"
 #include "util/log.hpp"
+#include "util/blocking_probe.hpp"
+#include "util/mem_governor.hpp"
 
 #include <NetworkManager.h>
 #include <gio/gio.h>
@@ -25,6 +28,7 @@
 #include <algorithm>
 #include <atomic>
 #include <map>
+#include <mutex>
 
 namespace provision::wifi {
 
@@ -36,6 +40,37 @@ namespace {
 
 static std::atomic_bool g_scan_busy{false};
 
+// Latest scan, strongest AP per SSID.
+static std::mutex g_records_mutex;
+static std::map<std::string, ScanRecord> g_records;
+
+/**
+ * Approximate heap footprint of one cached record (map node + strings).
+ */
+size_t record_cost(const std::string& key, const ScanRecord& rec)
+{
+    return sizeof(ScanRecord) + 4 * sizeof(void*) + key.size() + rec.ssid.size();
+}
+
+size_t records_bytes_locked()
+{
+    size_t bytes = 0;
+    for (const auto& kv : g_records)
+        bytes += record_cost(kv.first, kv.second);
+    return bytes;
+}
+
+/**
+ * Accounted only: connect() picks the key management from these records,
+ * and guessing for an evicted network breaks WPA3/OWE joins.
+ */
+provision::mem::ConsumerId cache_consumer()
+{
+    static const provision::mem::ConsumerId id = provision::mem::register_consumer(
+        "scan cache", provision::mem::Tier::SCAN_CACHE, nullptr);
+    return id;
+}
+
 struct ScanBusyGuard {
     bool acquired{false};
 
@@ -80,6 +115,9 @@ static std::string ssid_to_string(GBytes* ssid_bytes)
 
 std::vector<std::string> scan_ssids()
 {
+    if (sim_backend_enabled())
+        return sim_scan_ssids();
+
     ScanBusyGuard guard;
     if (!guard.acquired) {
         provision::log::warn("wifi_scan: ignored (busy)");
@@ -91,7 +129,11 @@ std::vector<std::string> scan_ssids()
     std::vector<std::string> result;
     GError* err = nullptr;
 
-    NMClient* client = nm_client_new(nullptr, &err);
+    NMClient* client = nullptr;
+    {
+        PROVISION_BLOCKING_CALL_KNOWN("nm_client_new");
+        client = nm_client_new(nullptr, &err);
+    }
     if (!client) {
         provision::log::error("wifi_scan: NMClient init failed");
         if (err) g_error_free(err);
@@ -131,7 +173,10 @@ std::vector<std::string> scan_ssids()
     }
 
     // Allow scan results to populate
-    g_usleep(700 * 1000);
+    {
+        PROVISION_BLOCKING_CALL_KNOWN("g_usleep");
+        g_usleep(700 * 1000);
+    }
 
     const GPtrArray* aps = nm_device_wifi_get_access_points(wifi);
     if (!aps) {
@@ -140,7 +185,7 @@ std::vector<std::string> scan_ssids()
         return result;
     }
 
-    std::map<std::string, int> best_strength;
+    std::map<std::string, ScanRecord> best;
 
     for (guint i = 0; i < aps->len; ++i) {
         NMAccessPoint* ap = NM_ACCESS_POINT(g_ptr_array_index(aps, i));
@@ -154,14 +199,21 @@ std::vector<std::string> scan_ssids()
 
         int strength = static_cast<int>(nm_access_point_get_strength(ap));
 
-        auto it = best_strength.find(ssid);
-        if (it == best_strength.end() || strength > it->second)
-            best_strength[ssid] = strength;
+        auto it = best.find(ssid);
+        if (it == best.end() || strength > it->second.strength) {
+            best[ssid] = ScanRecord{
+                ssid,
+                strength,
+                static_cast<std::uint32_t>(nm_access_point_get_flags(ap)),
+                static_cast<std::uint32_t>(nm_access_point_get_wpa_flags(ap)),
+                static_cast<std::uint32_t>(nm_access_point_get_rsn_flags(ap))
+            };
+        }
     }
 
     std::vector<std::pair<std::string, int>> sorted;
-    for (const auto& kv : best_strength)
-        sorted.emplace_back(kv);
+    for (const auto& kv : best)
+        sorted.emplace_back(kv.first, kv.second.strength);
 
     std::sort(sorted.begin(), sorted.end(),
               [](const auto& a, const auto& b) {
@@ -174,8 +226,28 @@ std::vector<std::string> scan_ssids()
     provision::log::info(
         "wifi_scan: found " + std::to_string(result.size()) + " SSIDs");
 
+    size_t cache_bytes = 0;
+    {
+        std::lock_guard<std::mutex> lock(g_records_mutex);
+        g_records = std::move(best);
+        cache_bytes = records_bytes_locked();
+    }
+    provision::mem::set_usage(cache_consumer(), cache_bytes);
+
     g_object_unref(client);
     return result;
 }
 
+bool lookup_scan_record(const std::string& ssid, ScanRecord& out)
+{
+    std::lock_guard<std::mutex> lock(g_records_mutex);
+
+    auto it = g_records.find(ssid);
+    if (it == g_records.end())
+        return false;
+
+    out = it->second;
+    return true;
+}
+
 } // namespace provision::wifi
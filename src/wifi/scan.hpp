@@ -5,8 +5,9 @@
  *   Wi-Fi scanning helpers using NetworkManager.
  *
  * Notes:
- *   - Stateless utility module
  *   - Returns SSIDs sorted by signal strength (descending)
+ *   - Keeps the security flags of the strongest AP per SSID from the
+ *     latest scan, so connect() can pick the right key management
  *   - No BLE knowledge, no side effects beyond logging
  *
  * License:
@@ -25,11 +26,24 @@
  */
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
 namespace provision::wifi {
 
+/**
+ * Security flags of one SSID as advertised by its strongest AP
+ * (NM80211ApFlags / NM80211ApSecurityFlags values).
+ */
+struct ScanRecord {
+    std::string ssid;
+    int strength{0};
+    std::uint32_t flags{0};
+    std::uint32_t wpa_flags{0};
+    std::uint32_t rsn_flags{0};
+};
+
 /**
  * Perform a one-shot Wi-Fi scan and return SSIDs sorted by strength.
  *
@@ -37,4 +51,9 @@ namespace provision::wifi {
  */
 std::vector<std::string> scan_ssids();
 
+/**
+ * Record for ssid from the latest scan. False if it was not seen.
+ */
+bool lookup_scan_record(const std::string& ssid, ScanRecord& out);
+
 } // namespace provision::wifi
@@ -0,0 +1,111 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   Implementation of the simulated Wi-Fi environment.
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+
+#include "wifi/sim_backend.hpp"
+#include "wifi/wifi_state_dispatcher.hpp"
+#include "gatt/state.hpp"
+#include "util/config.hpp"
+#include "util/log.hpp"
+
+#include <glib.h>
+
+namespace provision::wifi {
+
+namespace {
+
+static bool g_connected = false;
+static std::string g_ssid;
+static guint g_connect_source = 0;
+
+gboolean on_link_up(gpointer)
+{
+    g_connect_source = 0;
+    g_connected = true;
+
+    provision::log::info("wifi_sim: link up ssid=" + g_ssid);
+    notify_ipv4_ready();
+    return G_SOURCE_REMOVE;
+}
+
+gboolean on_auth_failed(gpointer)
+{
+    g_connect_source = 0;
+
+    provision::log::warn("wifi_sim: wrong psk for " + g_ssid + ", link stays down");
+    provision::gatt::notify_state_connect_failed(g_ssid, "wrong psk");
+    return G_SOURCE_REMOVE;
+}
+
+} // namespace
+
+bool sim_backend_enabled()
+{
+    static const bool enabled =
+        provision::config::get_string("wifi", "backend", "nm") == "sim";
+    return enabled;
+}
+
+std::vector<std::string> sim_scan_ssids()
+{
+    std::vector<std::string> out;
+
+    const std::string list = provision::config::get_string("sim", "ssids", "SimNet");
+    gchar** parts = g_strsplit(list.c_str(), ",", -1);
+    for (gchar** p = parts; p && *p; ++p) {
+        g_strstrip(*p);
+        if (**p)
+            out.emplace_back(*p);
+    }
+    g_strfreev(parts);
+
+    provision::log::info("wifi_sim: scan found " + std::to_string(out.size()) + " SSIDs");
+    return out;
+}
+
+ConnectResult sim_connect(const std::string& ssid, const std::string& psk)
+{
+    provision::log::info("wifi_sim: connecting ssid=" + ssid);
+
+    if (g_connect_source) {
+        g_source_remove(g_connect_source);
+        g_connect_source = 0;
+    }
+    g_connected = false;
+    g_ssid = ssid;
+
+    // A wrong key fails after the same delay, like NM's async failure.
+    const std::string want = provision::config::get_string("sim", "psk", "");
+    const bool accepted = want.empty() || psk == want;
+
+    const long delay_ms = provision::config::get_int("sim", "connect_ms", 500);
+    g_connect_source = g_timeout_add(static_cast<guint>(delay_ms),
+                                     accepted ? on_link_up : on_auth_failed, nullptr);
+    return ConnectResult::REQUESTED;
+}
+
+bool sim_link(std::string& ssid, std::string& ip)
+{
+    if (!g_connected)
+        return false;
+
+    ssid = g_ssid;
+    ip = provision::config::get_string("sim", "ip", "10.0.0.2");
+    return true;
+}
+
+} // namespace provision::wifi
@@ -0,0 +1,59 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   Simulated Wi-Fi environment used instead of NetworkManager.
+ *
+ * Notes:
+ *   - Selected with [wifi] backend=sim; meant for the fleet simulator
+ *     (provision-fleet), where many daemons share one private bus and
+ *     there is no NetworkManager or wlan0
+ *   - [sim] ssids   comma-separated scan result (strongest first)
+ *     [sim] psk     required passphrase; empty accepts any
+ *     [sim] connect_ms  delay before the link comes up (default 500)
+ *     [sim] ip      address reported once connected (default 10.0.0.2)
+ *   - Main-context only
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+#pragma once
+
+#include "wifi/connect.hpp"
+
+#include <string>
+#include <vector>
+
+namespace provision::wifi {
+
+/**
+ * True if [wifi] backend=sim.
+ */
+bool sim_backend_enabled();
+
+/**
+ * Configured scan result.
+ */
+std::vector<std::string> sim_scan_ssids();
+
+/**
+ * Simulated activation: after [sim] connect_ms the link comes up and the
+ * usual IPv4-ready path runs. A wrong psk is dropped silently, just like
+ * an NM activation that never gets an address.
+ */
+ConnectResult sim_connect(const std::string& ssid, const std::string& psk);
+
+/**
+ * Current simulated link. Returns false while not connected.
+ */
+bool sim_link(std::string& ssid, std::string& ip);
+
+} // namespace provision::wifi
@@ -18,15 +18,68 @@
  
 #include "wifi/wifi_state_dispatcher.hpp"
 #include "util/log.hpp"
+#include "util/blocking_probe.hpp"
+#include "util/trace.hpp"
 #include "gatt/state.hpp"
+#include "dbus/agent.hpp"
+#include "wifi/mdns.hpp"
+#include "wifi/connectivity_watchdog.hpp"
+#include "wifi/sim_backend.hpp"
 #include <NetworkManager.h>
 #include <glib.h>
 
 namespace provision::wifi {
 
+/* IPv4 of the link we last saw come up (empty: down), and the mDNS name
+   announced for it. StartNotify re-publishes CONNECTED for the same link
+   and must not restart announcements or the bond purge. */
+static std::string g_link_ip;
+static std::string g_link_mdns;
+
+/*
+ * Publish CONNECTED for an active link and leave the provisioning window.
+ */
+static void on_link_connected(const std::string& ssid, const std::string& ip)
+{
+    PROVISION_TRACE2(connect_phase, ssid.c_str(), "ipv4");
+
+    const bool link_up = ip != g_link_ip;
+
+    provision::log::info(
+        "wifi connected ssid=" + ssid + " ip=" + ip +
+        (link_up ? "" : " (unchanged)")
+    );
+
+    if (link_up) {
+        g_link_ip = ip;
+        /* announce first so the name is resolvable when the client
+           reads it from the CONNECTED payload */
+        g_link_mdns = provision::wifi::mdns_announce(ip);
+    }
+    provision::gatt::notify_state_connected(ssid, ip, g_link_mdns);
+
+    if (link_up) {
+        /* provisioning window is over: drop bonds made during it */
+        provision::bluez::schedule_bond_purge();
+    }
+
+    provision::wifi::watchdog_link_up();
+}
+
 static gboolean on_ipv4_ready(gpointer)
 {
-    NMClient* client = nm_client_new(nullptr, nullptr);
+    if (provision::wifi::sim_backend_enabled()) {
+        std::string ssid, ip;
+        if (provision::wifi::sim_link(ssid, ip))
+            on_link_connected(ssid, ip);
+        return G_SOURCE_REMOVE;
+    }
+
+    NMClient* client = nullptr;
+    {
+        PROVISION_BLOCKING_CALL_KNOWN("nm_client_new");
+        client = nm_client_new(nullptr, nullptr);
+    }
     if (!client)
         return G_SOURCE_REMOVE;
 
@@ -65,13 +118,8 @@ static gboolean on_ipv4_ready(gpointer)
         }
     }
 
-    if (!ip.empty()) {
-        provision::log::info(
-            "wifi connected ssid=" + ssid + " ip=" + ip
-        );
-        provision::gatt::notify_state_connected(ssid, ip);
-        /* later: notify_state_connected(ssid, ip); */
-    }
+    if (!ip.empty())
+        on_link_connected(ssid, ip);
 
     g_object_unref(client);
     return G_SOURCE_REMOVE;
@@ -86,6 +134,25 @@ void notify_ipv4_ready()
     );
 }
 
+static gboolean on_ipv4_lost(gpointer)
+{
+    g_link_ip.clear();
+    g_link_mdns.clear();
+    /* the announced address is gone: withdraw it before caches go stale */
+    provision::wifi::mdns_stop();
+    provision::wifi::watchdog_link_lost();
+    return G_SOURCE_REMOVE;
+}
+
+void notify_ipv4_lost()
+{
+    g_main_context_invoke(
+        nullptr,          // default main context
+        on_ipv4_lost,
+        nullptr
+    );
+}
+
 void init_wifi_state_dispatcher()
 {
     /* intentionally empty for now */
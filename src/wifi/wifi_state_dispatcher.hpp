@@ -31,4 +31,10 @@ void init_wifi_state_dispatcher();
  */
 void notify_ipv4_ready();
 
+/**
+ * Called from the netlink thread when wlan0 loses IPv4.
+ * Safe to call from any thread.
+ */
+void notify_ipv4_lost();
+
 }
@@ -0,0 +1,393 @@
+/*
+ * Project: provision (BLE Provisioning for Raspberry Pi)
+ *
+ * Description:
+ *   Loopback test for the mDNS responder: joins 224.0.0.251:5353 on lo,
+ *   has the responder announce 127.0.0.1 there and checks the A, PTR,
+ *   SRV and TXT records, then the TTL-0 goodbye sent by mdns_stop().
+ *
+ * Notes:
+ *   - Runs the responder with [mdns] interface=lo from a temporary config
+ *   - Needs multicast on lo (ip link set lo multicast on); exits 77
+ *     (skipped under ctest) when the group cannot be joined there
+ *   - Exit 0 on success, 1 on failure
+ *
+ * Website:
+ *   https://pidevelop.com
+ *
+ * Contact:
+ *   james@pidevelop.com
+ *
+ * License:
+ *   MIT License (see LICENSE file at repo root)
+ *
+ * Copyright (c) 2026 PiDevelop
+ */
+
+#include "wifi/mdns.hpp"
+#include "util/config.hpp"
+
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr int EXIT_SKIP = 77;
+
+constexpr const char* MDNS_GROUP = "224.0.0.251";
+constexpr guint16 MDNS_PORT = 5353;
+constexpr const char* ANNOUNCED_IP = "127.0.0.1";
+constexpr guint16 SERVICE_PORT = 2222;
+
+constexpr guint16 TYPE_A   = 1;
+constexpr guint16 TYPE_PTR = 12;
+constexpr guint16 TYPE_TXT = 16;
+constexpr guint16 TYPE_SRV = 33;
+
+constexpr guint32 TTL_HOST = 120;
+constexpr guint32 TTL_SERVICE = 4500;
+
+constexpr gint64 WAIT_US = 5 * G_USEC_PER_SEC;
+
+struct Record {
+    std::string name;
+    guint16 type{0};
+    guint16 cls{0};
+    guint32 ttl{0};
+    size_t rdata_off{0};
+    guint16 rdata_len{0};
+};
+
+static bool g_failed = false;
+
+void expect(bool cond, const std::string& what)
+{
+    if (!cond) {
+        std::fprintf(stderr, "FAIL: %s\n", what.c_str());
+        g_failed = true;
+    }
+}
+
+guint16 get_u16(const guint8* p)
+{
+    return static_cast<guint16>((p[0] << 8) | p[1]);
+}
+
+guint32 get_u32(const guint8* p)
+{
+    return (static_cast<guint32>(get_u16(p)) << 16) | get_u16(p + 2);
+}
+
+/**
+ * Read a (possibly compressed) name at off; advances off past it.
+ */
+bool read_name(const guint8* p, size_t len, size_t& off, std::string& out)
+{
+    size_t pos = off;
+    bool jumped = false;
+    int jumps = 0;
+
+    out.clear();
+
+    while (pos < len) {
+        const guint8 l = p[pos];
+
+        if (l == 0) {
+            if (!jumped)
+                off = pos + 1;
+            return true;
+        }
+
+        if ((l & 0xc0) == 0xc0) {
+            if (pos + 1 >= len || ++jumps > 16)
+                return false;
+            if (!jumped)
+                off = pos + 2;
+            jumped = true;
+            pos = static_cast<size_t>(((l & 0x3f) << 8) | p[pos + 1]);
+            continue;
+        }
+
+        if (pos + 1 + l > len)
+            return false;
+
+        if (!out.empty())
+            out += '.';
+        out.append(reinterpret_cast<const char*>(p + pos + 1), l);
+        pos += 1 + l;
+    }
+
+    return false;
+}
+
+/**
+ * Answer section of a response packet. False for queries or garbage.
+ */
+bool parse_response(const guint8* p, size_t len, std::vector<Record>& out)
+{
+    out.clear();
+
+    if (len < 12 || !(get_u16(p + 2) & 0x8000))
+        return false;
+
+    const guint16 qdcount = get_u16(p + 4);
+    const guint16 ancount = get_u16(p + 6);
+
+    size_t off = 12;
+    std::string name;
+    for (guint16 i = 0; i < qdcount; ++i) {
+        if (!read_name(p, len, off, name) || off + 4 > len)
+            return false;
+        off += 4;
+    }
+
+    for (guint16 i = 0; i < ancount; ++i) {
+        Record r;
+        if (!read_name(p, len, off, r.name) || off + 10 > len)
+            return false;
+
+        r.type = get_u16(p + off);
+        r.cls = get_u16(p + off + 2);
+        r.ttl = get_u32(p + off + 4);
+        r.rdata_len = get_u16(p + off + 8);
+        r.rdata_off = off + 10;
+
+        off = r.rdata_off + r.rdata_len;
+        if (off > len)
+            return false;
+
+        out.push_back(r);
+    }
+
+    return true;
+}
+
+const Record* find(const std::vector<Record>& recs, const std::string& name, guint16 type)
+{
+    for (const auto& r : recs) {
+        if (r.type == type && g_ascii_strcasecmp(r.name.c_str(), name.c_str()) == 0)
+            return &r;
+    }
+    return nullptr;
+}
+
+/**
+ * Same label the responder derives from the hostname.
+ */
+std::string local_host_label()
+{
+    std::string host = g_get_host_name();
+    const size_t dot = host.find('.');
+    if (dot != std::string::npos)
+        host.resize(dot);
+    return host;
+}
+
+GSocket* open_listener()
+{
+    GError* err = nullptr;
+    GSocket* sock = g_socket_new(G_SOCKET_FAMILY_IPV4,
+                                 G_SOCKET_TYPE_DATAGRAM,
+                                 G_SOCKET_PROTOCOL_UDP,
+                                 &err);
+    if (!sock) {
+        std::fprintf(stderr, "socket: %s\n", err ? err->message : "unknown error");
+        if (err) g_error_free(err);
+        return nullptr;
+    }
+
+    GInetAddress* any = g_inet_address_new_any(G_SOCKET_FAMILY_IPV4);
+    GSocketAddress* bind_addr = g_inet_socket_address_new(any, MDNS_PORT);
+    GInetAddress* group = g_inet_address_new_from_string(MDNS_GROUP);
+
+    const bool ok = g_socket_bind(sock, bind_addr, TRUE, &err) &&
+                    g_socket_join_multicast_group(sock, group, FALSE, "lo", &err);
+
+    g_object_unref(group);
+    g_object_unref(bind_addr);
+    g_object_unref(any);
+
+    if (!ok) {
+        std::fprintf(stderr, "bind/join on lo: %s\n", err ? err->message : "unknown error");
+        if (err) g_error_free(err);
+        g_object_unref(sock);
+        return nullptr;
+    }
+
+    g_socket_set_blocking(sock, FALSE);
+    return sock;
+}
+
+/**
+ * Iterate the main context (the responder runs there) until a response
+ * carrying our A record arrives whose TTL is zero (goodbye) or not.
+ */
+bool wait_for_response(GSocket* sock,
+                       const std::string& host_fqdn,
+                       bool goodbye,
+                       std::vector<guint8>& pkt,
+                       std::vector<Record>& recs)
+{
+    const gint64 deadline = g_get_monotonic_time() + WAIT_US;
+
+    while (g_get_monotonic_time() < deadline) {
+        while (g_main_context_iteration(nullptr, FALSE)) {}
+
+        if (!g_socket_condition_timed_wait(sock, G_IO_IN, 50 * 1000, nullptr, nullptr))
+            continue;
+
+        guint8 buf[1500];
+        const gssize n = g_socket_receive(sock, reinterpret_cast<gchar*>(buf),
+                                          sizeof(buf), nullptr, nullptr);
+        if (n <= 0)
+            continue;
+
+        pkt.assign(buf, buf + n);
+        if (!parse_response(pkt.data(), pkt.size(), recs))
+            continue;
+
+        const Record* a = find(recs, host_fqdn, TYPE_A);
+        if (a && (a->ttl == 0) == goodbye)
+            return true;
+    }
+
+    return false;
+}
+
+void check_records(const std::vector<guint8>& pkt,
+                   const std::vector<Record>& recs,
+                   const std::string& host,
+                   bool goodbye)
+{
+    const std::string host_fqdn = host + ".local";
+    const std::string service_fqdn = "_ssh._tcp.local";
+    const std::string instance_fqdn = host + "." + service_fqdn;
+
+    const guint32 ttl_host = goodbye ? 0 : TTL_HOST;
+    const guint32 ttl_service = goodbye ? 0 : TTL_SERVICE;
+    const std::string phase = goodbye ? "goodbye: " : "announce: ";
+
+    expect(recs.size() == 4, phase + "4 answers, got " + std::to_string(recs.size()));
+
+    const Record* a = find(recs, host_fqdn, TYPE_A);
+    expect(a != nullptr, phase + "A " + host_fqdn);
+    if (a) {
+        expect(a->cls == 0x8001, phase + "A class IN + cache-flush");
+        expect(a->ttl == ttl_host, phase + "A ttl");
+        expect(a->rdata_len == 4 &&
+               pkt[a->rdata_off] == 127 && pkt[a->rdata_off + 1] == 0 &&
+               pkt[a->rdata_off + 2] == 0 && pkt[a->rdata_off + 3] == 1,
+               phase + "A -> " + ANNOUNCED_IP);
+    }
+
+    const Record* ptr = find(recs, service_fqdn, TYPE_PTR);
+    expect(ptr != nullptr, phase + "PTR " + service_fqdn);
+    if (ptr) {
+        expect(ptr->cls == 0x0001, phase + "PTR class IN (shared)");
+        expect(ptr->ttl == ttl_service, phase + "PTR ttl");
+        std::string target;
+        size_t off = ptr->rdata_off;
+        expect(read_name(pkt.data(), pkt.size(), off, target) &&
+               g_ascii_strcasecmp(target.c_str(), instance_fqdn.c_str()) == 0,
+               phase + "PTR -> " + instance_fqdn + ", got " + target);
+    }
+
+    const Record* srv = find(recs, instance_fqdn, TYPE_SRV);
+    expect(srv != nullptr, phase + "SRV " + instance_fqdn);
+    if (srv) {
+        expect(srv->cls == 0x8001, phase + "SRV class IN + cache-flush");
+        expect(srv->ttl == ttl_host, phase + "SRV ttl");
+        expect(srv->rdata_len > 6, phase + "SRV rdata length");
+        if (srv->rdata_len > 6) {
+            const guint8* d = pkt.data() + srv->rdata_off;
+            expect(get_u16(d + 4) == SERVICE_PORT,
+                   phase + "SRV port " + std::to_string(SERVICE_PORT));
+            std::string target;
+            size_t off = srv->rdata_off + 6;
+            expect(read_name(pkt.data(), pkt.size(), off, target) &&
+                   g_ascii_strcasecmp(target.c_str(), host_fqdn.c_str()) == 0,
+                   phase + "SRV target " + host_fqdn + ", got " + target);
+        }
+    }
+
+    const Record* txt = find(recs, instance_fqdn, TYPE_TXT);
+    expect(txt != nullptr, phase + "TXT " + instance_fqdn);
+    if (txt) {
+        expect(txt->ttl == ttl_service, phase + "TXT ttl");
+        expect(txt->rdata_len == 1 && pkt[txt->rdata_off] == 0,
+               phase + "TXT is one empty string");
+    }
+}
+
+} // namespace
+
+int main()
+{
+    gchar* dir = g_dir_make_tmp("provision-mdns-XXXXXX", nullptr);
+    if (!dir) {
+        std::fprintf(stderr, "cannot create temp dir\n");
+        return 1;
+    }
+
+    gchar* conf = g_build_filename(dir, "provision.conf", nullptr);
+    const std::string contents =
+        "[mdns]\n"
+        "enabled=true\n"
+        "interface=lo\n"
+        "service=_ssh._tcp\n"
+        "port=" + std::to_string(SERVICE_PORT) + "\n"
+        "grace_s=60\n";
+    g_file_set_contents(conf, contents.c_str(), -1, nullptr);
+
+    provision::config::load(conf);
+
+    g_unlink(conf);
+    g_rmdir(dir);
+    g_free(conf);
+    g_free(dir);
+
+    GSocket* sock = open_listener();
+    if (!sock) {
+        std::fprintf(stderr, "SKIP: cannot join %s on lo\n", MDNS_GROUP);
+        return EXIT_SKIP;
+    }
+
+    const std::string host = local_host_label();
+    const std::string host_fqdn = host + ".local";
+
+    // No bus: mdns_stop() sends the goodbye itself instead of asking Avahi.
+    provision::wifi::init_mdns(nullptr);
+
+    const std::string name = provision::wifi::mdns_announce(ANNOUNCED_IP);
+    expect(name == host_fqdn, "mdns_announce returns " + host_fqdn + ", got '" + name + "'");
+
+    std::vector<guint8> pkt;
+    std::vector<Record> recs;
+
+    if (name.empty()) {
+        // Nothing will be sent.
+    } else if (wait_for_response(sock, host_fqdn, false, pkt, recs)) {
+        check_records(pkt, recs, host, false);
+
+        provision::wifi::mdns_stop();
+        if (wait_for_response(sock, host_fqdn, true, pkt, recs))
+            check_records(pkt, recs, host, true);
+        else
+            expect(false, "goodbye received after mdns_stop()");
+    } else {
+        expect(false, "announcement received on lo");
+    }
+
+    g_socket_close(sock, nullptr);
+    g_object_unref(sock);
+
+    if (g_failed)
+        return 1;
+
+    std::printf("mdns_announce_test: ok\n");
+    return 0;
+}